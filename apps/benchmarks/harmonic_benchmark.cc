@@ -0,0 +1,254 @@
+/**
+  * Benchmarks the linear solves of harmonic() on disk-shaped regions of a target mesh,
+  * sized like the flap regions in smooth_paths and the patches in parametrize_patches.
+  * As there, each region is extracted into its own mesh and constrained on its boundary.
+  *
+  * Compares the reduced system (constrained vertices eliminated) with LU and Cholesky
+  * against the previous formulation, which kept constrained vertices as identity rows.
+  * All configurations solve the same region.
+  * Also times the serial (triplets) and parallel (direct row fill) matrix assembly.
+  */
+
+#include <LayoutEmbedding/Harmonic.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/StackTrace.hh>
+
+#include <glow-extras/timing/CpuTimer.hh>
+
+#include <polymesh/formats.hh>
+
+#include <Eigen/SparseLU>
+
+#include <cxxopts.hpp>
+
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <queue>
+
+using namespace LayoutEmbedding;
+namespace fs = std::filesystem;
+
+namespace {
+
+/// Disk-shaped region of a mesh, extracted into its own mesh and constrained on its boundary
+/// (like the flap regions in smooth_paths and the patches in parametrize_patches).
+struct Disc
+{
+    pm::Mesh m;
+    pm::vertex_attribute<tg::pos3> pos{m};
+    pm::vertex_attribute<bool> constrained{m};
+    Eigen::MatrixXd constraint_values;
+    int n_free = 0;
+};
+
+/// Grows a disc of triangles around _seed until it has _n_free interior vertices (or cannot grow further).
+/// Faces are only attached along a single edge (with a new opposite vertex) or fill a notch between two edges,
+/// so the region stays a topological disc.
+void extract_disc(const pm::Mesh& _m, const pm::vertex_attribute<tg::pos3>& _pos, const pm::face_handle& _seed, const int _n_free, Disc& _disc)
+{
+    auto in_disc = _m.faces().make_attribute<bool>(false);
+    auto n_disc_faces = _m.vertices().make_attribute<int>(0);
+    std::vector<pm::face_handle> disc_faces;
+    std::queue<pm::face_handle> queue;
+    int n_interior = 0;
+
+    auto add_face = [&](const pm::face_handle& _f) {
+        in_disc[_f] = true;
+        disc_faces.push_back(_f);
+        for (const auto v : _f.vertices()) {
+            ++n_disc_faces[v];
+            if (!v.is_boundary() && n_disc_faces[v] == v.outgoing_halfedges().size()) {
+                ++n_interior;
+            }
+        }
+        for (const auto h : _f.halfedges()) {
+            const auto f = h.opposite_face();
+            if (f.is_valid() && !in_disc[f]) {
+                queue.push(f);
+            }
+        }
+    };
+
+    add_face(_seed);
+    while (!queue.empty() && n_interior < _n_free) {
+        const auto f = queue.front();
+        queue.pop();
+        if (in_disc[f]) {
+            continue;
+        }
+
+        int n_shared = 0;
+        pm::vertex_handle v_opposite;
+        for (const auto h : f.halfedges()) {
+            const auto f_opp = h.opposite_face();
+            if (f_opp.is_valid() && in_disc[f_opp]) {
+                ++n_shared;
+                v_opposite = h.next().vertex_to();
+            }
+        }
+        if ((n_shared == 1 && n_disc_faces[v_opposite] == 0) || n_shared == 2) {
+            add_face(f);
+        }
+    }
+
+    auto v_disc = _m.vertices().make_attribute<pm::vertex_handle>();
+    for (const auto f : disc_faces) {
+        for (const auto v : f.vertices()) {
+            if (v_disc[v].is_invalid()) {
+                v_disc[v] = _disc.m.vertices().add();
+                _disc.pos[v_disc[v]] = _pos[v];
+            }
+        }
+        _disc.m.faces().add(f.vertices().to_vector([&] (auto v) { return v_disc[v]; }));
+    }
+
+    // Parametrization-like constraints: positions projected to the xy-plane
+    _disc.constraint_values = Eigen::MatrixXd::Zero(_disc.m.vertices().size(), 2);
+    _disc.n_free = 0;
+    for (const auto v : _disc.m.vertices()) {
+        _disc.constrained[v] = v.is_boundary();
+        _disc.constraint_values.row(v.idx.value) = Eigen::Vector2d(_disc.pos[v].x, _disc.pos[v].y);
+        if (!v.is_boundary()) {
+            ++_disc.n_free;
+        }
+    }
+}
+
+/// Previous formulation: full n x n system with identity rows for constrained vertices, solved via LU.
+bool harmonic_full_lu(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::vertex_attribute<bool>& _constrained,
+        const Eigen::MatrixXd& _constraint_values,
+        Eigen::MatrixXd& _res)
+{
+    const int n = _pos.mesh().vertices().size();
+    Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero(n, _constraint_values.cols());
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (auto v : _pos.mesh().vertices()) {
+        const int i = v.idx.value;
+        if (_constrained[v]) {
+            triplets.push_back(Eigen::Triplet<double>(i, i, 1.0));
+            rhs.row(i) = _constraint_values.row(i);
+        }
+        else {
+            for (auto h : v.outgoing_halfedges()) {
+                triplets.push_back(Eigen::Triplet<double>(i, h.vertex_to().idx.value, 1.0));
+                triplets.push_back(Eigen::Triplet<double>(i, i, -1.0));
+            }
+        }
+    }
+    Eigen::SparseMatrix<double> L(n, n);
+    L.setFromTriplets(triplets.begin(), triplets.end());
+
+    Eigen::SparseLU<Eigen::SparseMatrix<double>> solver;
+    solver.compute(L);
+    if (solver.info() != Eigen::Success) {
+        return false;
+    }
+    _res = solver.solve(rhs);
+    return solver.info() == Eigen::Success;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    register_segfault_handler();
+
+    fs::path mesh_path = fs::path(LE_DATA_PATH) / "models/target-meshes/pig/pig_union.obj";
+    std::vector<int> region_sizes = { 1000, 5000, 20000, 50000 };
+    int repetitions = 3;
+
+    cxxopts::Options opts("harmonic_benchmark", "Benchmarks the sparse solves in harmonic() for several region sizes.");
+    opts.add_options()("m,mesh", "Path to a triangle mesh.", cxxopts::value<std::string>());
+    opts.add_options()("s,sizes", "Numbers of free (interior) vertices of the regions.", cxxopts::value<std::vector<int>>());
+    opts.add_options()("r,repetitions", "Repetitions per configuration (the minimum time is reported).", cxxopts::value<int>()->default_value("3"));
+    opts.add_options()("h,help", "Help.");
+    try {
+        auto args = opts.parse(argc, argv);
+        if (args.count("help")) {
+            std::cout << opts.help() << std::endl;
+            return 0;
+        }
+        if (args.count("mesh")) {
+            mesh_path = args["mesh"].as<std::string>();
+        }
+        if (args.count("sizes")) {
+            region_sizes = args["sizes"].as<std::vector<int>>();
+        }
+        repetitions = args["repetitions"].as<int>();
+    }
+    catch (const cxxopts::OptionException& e) {
+        std::cout << e.what() << "\n\n";
+        std::cout << opts.help() << std::endl;
+        return 1;
+    }
+
+    pm::Mesh m;
+    auto pos = m.vertices().make_attribute<tg::pos3>();
+    LE_ASSERT(pm::load(mesh_path.string(), m, pos));
+    m.compactify();
+    std::cout << "Mesh with " << m.vertices().size() << " vertices." << std::endl;
+
+    struct Config
+    {
+        std::string name;
+        LaplaceWeights weights;
+        HarmonicSolver solver;
+    };
+    const std::vector<Config> configs = {
+        { "mean_value_lu", LaplaceWeights::MeanValue, HarmonicSolver::LU },
+        { "uniform_lu", LaplaceWeights::Uniform, HarmonicSolver::LU },
+        { "uniform_cholesky", LaplaceWeights::Uniform, HarmonicSolver::Cholesky },
+        { "cotangent_lu", LaplaceWeights::Cotangent, HarmonicSolver::LU },
+        { "cotangent_cholesky", LaplaceWeights::Cotangent, HarmonicSolver::Cholesky },
+    };
+
+    std::cout << "n_free,config,t_min" << std::endl;
+    for (const int size : region_sizes) {
+        Disc disc;
+        extract_disc(m, pos, m.faces().first(), size, disc);
+        const int n_free = disc.n_free;
+
+        auto benchmark = [&](const std::string& _name, const std::function<bool(Eigen::MatrixXd&)>& _solve) {
+            double t_min = std::numeric_limits<double>::infinity();
+            for (int r = 0; r < repetitions; ++r) {
+                Eigen::MatrixXd res;
+                glow::timing::CpuTimer timer;
+                const bool success = _solve(res);
+                t_min = std::min(t_min, timer.elapsedSecondsD());
+                if (!success) {
+                    std::cout << n_free << "," << _name << ",failed" << std::endl;
+                    return;
+                }
+            }
+            std::cout << n_free << "," << _name << "," << t_min << std::endl;
+        };
+
+        // Assembly only
+        for (const bool parallel : { false, true }) {
+            for (const auto weights : { LaplaceWeights::Uniform, LaplaceWeights::MeanValue }) {
+                const std::string name = std::string("assemble_") + (weights == LaplaceWeights::Uniform ? "uniform" : "mean_value") + (parallel ? "_parallel" : "_serial");
+                benchmark(name, [&](Eigen::MatrixXd& _rhs) {
+                    Eigen::SparseMatrix<double> L;
+                    std::vector<int> free_idx;
+                    assemble_reduced_laplacian(disc.pos, disc.constrained, disc.constraint_values, weights, parallel, L, _rhs, free_idx);
+                    return true;
+                });
+            }
+        }
+
+        benchmark("uniform_full_lu", [&](Eigen::MatrixXd& _res) {
+            return harmonic_full_lu(disc.pos, disc.constrained, disc.constraint_values, _res);
+        });
+        for (const auto& config : configs) {
+            HarmonicSettings settings;
+            settings.weights = config.weights;
+            settings.solver = config.solver;
+            benchmark(config.name, [&](Eigen::MatrixXd& _res) {
+                return harmonic(disc.pos, disc.constrained, disc.constraint_values, _res, settings);
+            });
+        }
+    }
+}
@@ -0,0 +1,224 @@
+/**
+  * Benchmarks the orientation tests used by snake tracing (segment intersections) and
+  * quad mesh extraction (point in triangle).
+  *
+  * Compares the exact predicate of [Shewchuk1997] against the filtered predicates in
+  * Predicates.hh, both on random (well-conditioned) and on nearly collinear inputs.
+  * All configurations have to agree on the number of intersections (resp. contained points).
+  */
+
+#include <LayoutEmbedding/ExactPredicates.h>
+#include <LayoutEmbedding/Predicates.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/StackTrace.hh>
+
+#include <glow-extras/timing/CpuTimer.hh>
+
+#include <cxxopts.hpp>
+
+#include <functional>
+#include <iostream>
+#include <random>
+
+using namespace LayoutEmbedding;
+
+namespace {
+
+struct Segments
+{
+    tg::dpos2 a, b, c, d;
+};
+
+/// Random segment pairs. If _degenerate, c and d lie on the line through a and b (up to rounding).
+std::vector<Segments> random_segments(const int _n, const bool _degenerate)
+{
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<Segments> segments(_n);
+    for (auto& s : segments) {
+        s.a = { dist(rng), dist(rng) };
+        s.b = { dist(rng), dist(rng) };
+        if (_degenerate) {
+            s.c = s.a + dist(rng) * (s.b - s.a);
+            s.d = s.a + dist(rng) * (s.b - s.a);
+        }
+        else {
+            s.c = { dist(rng), dist(rng) };
+            s.d = { dist(rng), dist(rng) };
+        }
+    }
+    return segments;
+}
+
+struct PointTriangle
+{
+    tg::dpos2 p, a, b, c;
+};
+
+/// Random points and triangles. If _degenerate, p lies on the line through a and b (up to rounding).
+std::vector<PointTriangle> random_point_triangles(const int _n, const bool _degenerate)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<PointTriangle> point_triangles(_n);
+    for (auto& pt : point_triangles) {
+        pt.a = { dist(rng), dist(rng) };
+        pt.b = { dist(rng), dist(rng) };
+        pt.c = { dist(rng), dist(rng) };
+        if (_degenerate) {
+            pt.p = pt.a + dist(rng) * (pt.b - pt.a);
+        }
+        else {
+            pt.p = { dist(rng), dist(rng) };
+        }
+    }
+    return point_triangles;
+}
+
+int intersections_exact(const std::vector<Segments>& _segments)
+{
+    int n = 0;
+    for (const auto& s : _segments) {
+        const double s1 = orient2d(&s.a.x, &s.b.x, &s.c.x);
+        const double s2 = orient2d(&s.a.x, &s.d.x, &s.b.x);
+        const double s3 = orient2d(&s.a.x, &s.d.x, &s.c.x);
+        const double s4 = orient2d(&s.b.x, &s.c.x, &s.d.x);
+        n += (s1 <= 0 && s2 <= 0 && s3 <= 0 && s4 <= 0) || (s1 >= 0 && s2 >= 0 && s3 >= 0 && s4 >= 0);
+    }
+    return n;
+}
+
+int intersections_filtered(const std::vector<Segments>& _segments)
+{
+    int n = 0;
+    for (const auto& s : _segments) {
+        const int s1 = orient2d_sign(s.a, s.b, s.c);
+        const int s2 = orient2d_sign(s.a, s.d, s.b);
+        const int s3 = orient2d_sign(s.a, s.d, s.c);
+        const int s4 = orient2d_sign(s.b, s.c, s.d);
+        n += (s1 <= 0 && s2 <= 0 && s3 <= 0 && s4 <= 0) || (s1 >= 0 && s2 >= 0 && s3 >= 0 && s4 >= 0);
+    }
+    return n;
+}
+
+int intersections_batched(const std::vector<Segments>& _segments)
+{
+    int n = 0;
+    for (const auto& s : _segments) {
+        const auto signs = orient2d_signs<4>({ s.a, s.a, s.a, s.b }, { s.b, s.d, s.d, s.c }, { s.c, s.b, s.c, s.d });
+        n += (signs[0] <= 0 && signs[1] <= 0 && signs[2] <= 0 && signs[3] <= 0) ||
+             (signs[0] >= 0 && signs[1] >= 0 && signs[2] >= 0 && signs[3] >= 0);
+    }
+    return n;
+}
+
+/// Inclusive for both orientations of the triangle.
+int contained_exact(const std::vector<PointTriangle>& _point_triangles)
+{
+    int n = 0;
+    for (const auto& pt : _point_triangles) {
+        const double s1 = orient2d(&pt.p.x, &pt.a.x, &pt.b.x);
+        const double s2 = orient2d(&pt.p.x, &pt.b.x, &pt.c.x);
+        const double s3 = orient2d(&pt.p.x, &pt.c.x, &pt.a.x);
+        n += (s1 <= 0 && s2 <= 0 && s3 <= 0) || (s1 >= 0 && s2 >= 0 && s3 >= 0);
+    }
+    return n;
+}
+
+int contained_filtered(const std::vector<PointTriangle>& _point_triangles)
+{
+    int n = 0;
+    for (const auto& pt : _point_triangles) {
+        const int s1 = orient2d_sign(pt.p, pt.a, pt.b);
+        const int s2 = orient2d_sign(pt.p, pt.b, pt.c);
+        const int s3 = orient2d_sign(pt.p, pt.c, pt.a);
+        n += (s1 <= 0 && s2 <= 0 && s3 <= 0) || (s1 >= 0 && s2 >= 0 && s3 >= 0);
+    }
+    return n;
+}
+
+int contained_batched(const std::vector<PointTriangle>& _point_triangles)
+{
+    int n = 0;
+    for (const auto& pt : _point_triangles) {
+        const auto signs = orient2d_signs<3>({ pt.p, pt.p, pt.p }, { pt.a, pt.b, pt.c }, { pt.b, pt.c, pt.a });
+        n += (signs[0] <= 0 && signs[1] <= 0 && signs[2] <= 0) ||
+             (signs[0] >= 0 && signs[1] >= 0 && signs[2] >= 0);
+    }
+    return n;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    register_segfault_handler();
+
+    int n = 1000000;
+    int repetitions = 5;
+
+    cxxopts::Options opts("predicates_benchmark", "Benchmarks exact and filtered orientation predicates.");
+    opts.add_options()("n,num", "Number of segment pairs (resp. point-triangle pairs).", cxxopts::value<int>()->default_value("1000000"));
+    opts.add_options()("r,repetitions", "Repetitions per configuration (the minimum time is reported).", cxxopts::value<int>()->default_value("5"));
+    opts.add_options()("h,help", "Help.");
+    try {
+        auto args = opts.parse(argc, argv);
+        if (args.count("help")) {
+            std::cout << opts.help() << std::endl;
+            return 0;
+        }
+        n = args["num"].as<int>();
+        repetitions = args["repetitions"].as<int>();
+    }
+    catch (const cxxopts::OptionException& e) {
+        std::cout << e.what() << "\n\n";
+        std::cout << opts.help() << std::endl;
+        return 1;
+    }
+
+    init_exact_predicates();
+
+    struct Config
+    {
+        std::string name;
+        std::function<int()> count;
+    };
+
+    std::cout << "test,input,config,t_min,count" << std::endl;
+    auto benchmark = [&](const std::string& _test, const std::string& _input, const std::vector<Config>& _configs) {
+        std::vector<int> counts;
+        for (const auto& config : _configs) {
+            double t_min = std::numeric_limits<double>::infinity();
+            int count = 0;
+            for (int r = 0; r < repetitions; ++r) {
+                glow::timing::CpuTimer timer;
+                count = config.count();
+                t_min = std::min(t_min, timer.elapsedSecondsD());
+            }
+            std::cout << _test << "," << _input << "," << config.name << "," << t_min << "," << count << std::endl;
+            counts.push_back(count);
+        }
+        // All configurations have to agree
+        for (const int count : counts) {
+            LE_ASSERT_EQ(count, counts.front());
+        }
+    };
+
+    for (const bool degenerate : { false, true }) {
+        const std::string input = degenerate ? "collinear" : "random";
+
+        const auto segments = random_segments(n, degenerate);
+        benchmark("segment_intersection", input, {
+            { "exact", [&] { return intersections_exact(segments); } },
+            { "filtered", [&] { return intersections_filtered(segments); } },
+            { "batched", [&] { return intersections_batched(segments); } },
+        });
+
+        const auto point_triangles = random_point_triangles(n, degenerate);
+        benchmark("point_in_triangle", input, {
+            { "exact", [&] { return contained_exact(point_triangles); } },
+            { "filtered", [&] { return contained_filtered(point_triangles); } },
+            { "batched", [&] { return contained_batched(point_triangles); } },
+        });
+    }
+}
@@ -71,12 +71,13 @@ int main(int argc, char** argv)
         matching_target_vertices.push_back(t_v);
     }
 
+    // One distance field per landmark, sharing the heat method precomputation
+    const HeatGeodesicSolver geodesic_solver(input.t_pos);
+    const Eigen::MatrixXd landmark_distances = geodesic_solver.distances(matching_target_vertices);
     auto geodesic_distance = input.l_m.vertices().make_attribute<std::vector<double>>();
     for (const auto l_v : input.l_m.vertices()) {
-        const auto& t_v = input.l_matching_vertex[l_v];
-        auto da = approximate_geodesic_distance(input.t_pos, t_v);
-        auto d = da.to_vector();
-        geodesic_distance[l_v] = d;
+        const Eigen::VectorXd d = landmark_distances.col(l_v.idx.value);
+        geodesic_distance[l_v] = std::vector<double>(d.data(), d.data() + d.size());
     }
 
     const fs::path stats_path = jitter_evaluation_output_dir / "stats.csv";
@@ -54,7 +54,7 @@ int main()
     fs::create_directories(bnb_ablation_output_dir);
     {
         std::ofstream f(stats_path);
-        f << "mesh_id,state_hashing,proactive_pruning,balanced_priority,advanced_lower_bounds,runtime,last_upper_bound_event_t,score" << std::endl;
+        f << "mesh_id,state_hashing,proactive_pruning,balanced_priority,advanced_lower_bounds,conflict_penalties,runtime,last_upper_bound_event_t,score,num_iters,exact" << std::endl;
     }
 
     struct Configuration
@@ -63,13 +63,15 @@ int main()
         bool proactive_pruning = true;
         bool balanced_priority = true;
         bool advanced_lower_bounds = true;
+        bool conflict_penalties = false;
     };
     std::vector<Configuration> configs;
-    configs.push_back({true,  true,  true,  true });
-    configs.push_back({false, true,  true,  true });
-    configs.push_back({true,  false, true,  true });
-    configs.push_back({true,  true,  false, true });
-    configs.push_back({true,  true,  true,  false});
+    configs.push_back({true,  true,  true,  true,  false});
+    configs.push_back({false, true,  true,  true,  false});
+    configs.push_back({true,  false, true,  true,  false});
+    configs.push_back({true,  true,  false, true,  false});
+    configs.push_back({true,  true,  true,  false, false});
+    configs.push_back({true,  true,  true,  true,  true });
 
     const std::set<int> mesh_ids = { 1, 3, 4, 10, 11, 13, 44, 45, 46, 53, 54, 57, 58, 122, 123, 131, 132, 134, 135, 136, 137, 138, 139, 181, 182, 183, 184, 185, 186, 188, 190, 191, 192, 193, 194, 195, 197, 199, 200, 201, 202, 203, 204, 205, 206, 207, 208, 209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 223, 224, 225, 226, 227, 231, 232, 233, 234, 235, 236, 237, 238, 239, 240, 304, 305, 306, 307, 308, 310, 312, 319, 321, 322, 323, 324, 325, 326, 327, 328, 329, 330, 331, 332, 333, 334, 335, 336, 337, 338, 339, 340, 341, 342, 354, 388, 391, 399, 400 };
 
@@ -121,6 +123,7 @@ int main()
                 settings.use_state_hashing = config.state_hashing;
                 settings.use_proactive_pruning = config.proactive_pruning;
                 settings.use_candidate_paths_for_lower_bounds = config.advanced_lower_bounds;
+                settings.use_conflict_penalty_heuristic = config.conflict_penalties;
                 if (config.balanced_priority) {
                     settings.priority = BranchAndBoundSettings::Priority::LowerBoundNonConflicting;
                 }
@@ -146,9 +149,12 @@ int main()
                     f << config.proactive_pruning << ",";
                     f << config.balanced_priority << ",";
                     f << config.advanced_lower_bounds << ",";
+                    f << config.conflict_penalties << ",";
                     f << runtime << ",";
                     f << last_upper_bound_event_t << ",";
-                    f << embedding_cost << std::endl;
+                    f << embedding_cost << ",";
+                    f << result.num_iters << ",";
+                    f << result.exact << std::endl;
                 }
 
                 std::cout << "Mesh ID:               " << mesh_id << std::endl;
@@ -156,9 +162,12 @@ int main()
                 std::cout << "Proactive Pruning:     " << config.proactive_pruning << std::endl;
                 std::cout << "Balanced Priority:     " << config.balanced_priority << std::endl;
                 std::cout << "Advanced Lower Bounds: " << config.advanced_lower_bounds << std::endl;
+                std::cout << "Conflict Penalties:    " << config.conflict_penalties << std::endl;
                 std::cout << "Runtime:               " << runtime << std::endl;
                 std::cout << "Last UB Event:         " << last_upper_bound_event_t << std::endl;
                 std::cout << "Cost:                  " << embedding_cost << std::endl;
+                std::cout << "Iterations:            " << result.num_iters << std::endl;
+                std::cout << "Exact:                 " << result.exact << std::endl;
             }
         }
     }
@@ -78,6 +78,7 @@ void compute_embeddings(const std::string& _name, EmbeddingInput& _input)
         else if (algorithm == "bnb") {
             BranchAndBoundSettings settings;
             settings.time_limit = 5 * 60;
+            settings.record_memory_footprint_estimate = true;
             auto result = branch_and_bound(em, settings);
 
             double last_upper_bound_event_t = std::numeric_limits<double>::infinity();
@@ -0,0 +1,282 @@
+/**
+  * Long-running embedding server.
+  *
+  * Reads one job per line from stdin and answers each with one line on stdout.
+  * Target meshes are loaded once and kept in memory for all subsequent jobs that refer to the same file,
+  * together with the vertex repulsive energies [Praun2001] of the most recently used sets of landmarks on them.
+  * All other console output (logging, errors) is redirected to stderr.
+  *
+  * Requests:
+  *
+  *     embed <layout.obj> <target.obj> <landmarks|-> <algo> <output-prefix>
+  *         Embeds the layout into the target mesh and saves <output-prefix>.lem (+ meshes).
+  *         Landmarks are target vertex ids (one per line, in layout vertex order).
+  *         With "-", layout vertices are matched to the closest target vertices.
+  *         Algo is one of: bnb, greedy, praun, kraevoy, schreiner.
+  *         Answer: "ok <cost> <seconds> <output-prefix>.lem" or "error <message>".
+  *     stats
+  *         Answer: "stats <jobs> <failed> <busy-seconds> <jobs-per-busy-second> <cached-targets> <uptime-seconds>".
+  *         Busy seconds are the summed processing times of all embed requests (idle time is not counted).
+  *     evict <target.obj>
+  *         Removes a target mesh (and its energies) from the cache. Answer: "ok" (also if it was not cached).
+  *     quit
+  *
+  * To serve a Unix socket instead, wrap the server, e.g. with
+  *     socat UNIX-LISTEN:/tmp/embed.sock EXEC:./embed_server
+  */
+
+#include <LayoutEmbedding/BranchAndBound.hh>
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/EmbeddingInput.hh>
+#include <LayoutEmbedding/Greedy.hh>
+#include <LayoutEmbedding/LayoutGeneration.hh>
+#include <LayoutEmbedding/VertexRepulsiveEnergy.hh>
+#include <LayoutEmbedding/Util/StackTrace.hh>
+
+#include <glow-extras/timing/CpuTimer.hh>
+
+#include <polymesh/formats.hh>
+
+#include <cxxopts.hpp>
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+
+using namespace LayoutEmbedding;
+namespace fs = std::filesystem;
+
+namespace {
+
+/// Preprocessed target data shared by all jobs on the same target mesh.
+struct CachedTarget
+{
+    explicit CachedTarget(int _max_vre) :
+        vre(_max_vre)
+    {
+    }
+
+    pm::Mesh t_m;
+    pm::vertex_attribute<tg::pos3> t_pos{t_m};
+    SharedVertexRepulsiveEnergies vre; // Per set of landmarks, dense (#target vertices x #landmarks) each
+    int last_used = 0;
+};
+
+class TargetCache
+{
+public:
+    TargetCache(int _max_size, int _max_vre) :
+        max_size(_max_size),
+        max_vre(_max_vre)
+    {
+    }
+
+    CachedTarget& get(const fs::path& _path)
+    {
+        const auto key = fs::absolute(_path).string();
+        ++clock;
+        auto it = targets.find(key);
+        if (it != targets.end()) {
+            ++hits;
+            it->second->last_used = clock;
+            return *it->second;
+        }
+
+        auto target = std::make_unique<CachedTarget>(max_vre);
+        if (!pm::load(_path.string(), target->t_m, target->t_pos)) {
+            throw std::runtime_error("Could not load target mesh " + _path.string());
+        }
+        target->last_used = clock;
+
+        // Evict the least recently used target
+        if (!targets.empty() && targets.size() >= max_size) {
+            auto lru = targets.begin();
+            for (auto it_t = targets.begin(); it_t != targets.end(); ++it_t) {
+                if (it_t->second->last_used < lru->second->last_used) {
+                    lru = it_t;
+                }
+            }
+            targets.erase(lru);
+        }
+        return *(targets[key] = std::move(target));
+    }
+
+    void evict(const fs::path& _path)
+    {
+        targets.erase(fs::absolute(_path).string());
+    }
+
+    int size() const { return targets.size(); }
+
+    int hits = 0;
+
+private:
+    std::size_t max_size;
+    int max_vre;
+    int clock = 0;
+    std::map<std::string, std::unique_ptr<CachedTarget>> targets;
+};
+
+double run_job(TargetCache& _cache, const fs::path& _layout_path, const fs::path& _target_path, const std::string& _landmarks, const std::string& _algo, const std::string& _output_prefix)
+{
+    auto& target = _cache.get(_target_path);
+
+    EmbeddingInput input;
+    input.t_m.copy_from(target.t_m);
+    input.t_pos = input.t_m.vertices().make_attribute<tg::pos3>();
+    input.t_pos.copy_from(target.t_pos);
+    if (!pm::load(_layout_path.string(), input.l_m, input.l_pos)) {
+        throw std::runtime_error("Could not load layout mesh " + _layout_path.string());
+    }
+
+    if (_landmarks == "-") {
+        find_matching_vertices_by_proximity(input);
+    }
+    else {
+        const auto landmark_ids = load_landmarks(_landmarks, LandmarkFormat::id);
+        if (landmark_ids.size() != input.l_m.vertices().size()) {
+            throw std::runtime_error("Wrong number of landmarks.");
+        }
+        for (std::size_t i = 0; i < landmark_ids.size(); ++i) {
+            if (landmark_ids[i] < 0 || landmark_ids[i] >= input.t_m.vertices().size()) {
+                throw std::runtime_error("Invalid landmark id " + std::to_string(landmark_ids[i]));
+            }
+            input.l_matching_vertex[input.l_m.vertices()[i]] = input.t_m.vertices()[landmark_ids[i]];
+        }
+    }
+
+    Embedding em(input);
+    if (_algo == "praun" || _algo == "bnb") {
+        // Uses vertex repulsive tracing (in the greedy initialization of bnb)
+        target.vre.apply(em);
+    }
+
+    GreedySettings greedy_settings;
+    greedy_settings.progress.verbose = false;
+    if (_algo == "greedy")
+        embed_greedy(em, greedy_settings);
+    else if (_algo == "praun")
+        embed_praun(em, greedy_settings);
+    else if (_algo == "kraevoy")
+        embed_kraevoy(em, greedy_settings);
+    else if (_algo == "schreiner")
+        embed_schreiner(em, greedy_settings);
+    else if (_algo == "bnb") {
+        BranchAndBoundSettings settings;
+        settings.progress.verbose = false;
+        branch_and_bound(em, settings);
+    }
+    else
+        throw std::runtime_error("Invalid algo: " + _algo);
+
+    if (!em.is_complete()) {
+        throw std::runtime_error("No embedding found.");
+    }
+
+    const fs::path output_path = _output_prefix;
+    if (output_path.has_parent_path()) {
+        fs::create_directories(output_path.parent_path());
+    }
+    if (!em.save(_output_prefix)) {
+        throw std::runtime_error("Could not save " + _output_prefix);
+    }
+
+    return em.total_embedded_path_length();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    register_segfault_handler();
+
+    int max_cached_targets = 8;
+    int max_cached_energies = 4;
+
+    cxxopts::Options opts("embed_server",
+        "Embeds layouts into target meshes, reading one job per line from stdin.\n"
+        "Target meshes are kept in memory between jobs.\n"
+        "See the top of embed_server.cc for the protocol.\n");
+    opts.add_options()("c,cache", "Maximum number of cached target meshes.", cxxopts::value<int>()->default_value("8"));
+    opts.add_options()("e,energy-cache", "Maximum number of cached vertex repulsive energies (sets of landmarks) per target mesh. Set to <= 0 for no limit.", cxxopts::value<int>()->default_value("4"));
+    opts.add_options()("h,help", "Help.");
+    try {
+        auto args = opts.parse(argc, argv);
+        if (args.count("help")) {
+            std::cout << opts.help() << std::endl;
+            return 0;
+        }
+        max_cached_targets = args["cache"].as<int>();
+        max_cached_energies = args["energy-cache"].as<int>();
+    }
+    catch (const cxxopts::OptionException& e) {
+        std::cout << e.what() << "\n\n";
+        std::cout << opts.help() << std::endl;
+        return 1;
+    }
+
+    // Answers go to the original stdout, everything else to stderr.
+    std::ostream answers(std::cout.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    TargetCache cache(max_cached_targets, max_cached_energies);
+    glow::timing::CpuTimer uptime;
+    double t_busy = 0.0; // Seconds spent on embed requests
+    int num_jobs = 0;
+    int num_failed = 0;
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream request(line);
+        std::string command;
+        request >> command;
+
+        if (command.empty() || command[0] == '#') {
+            continue;
+        }
+        else if (command == "quit") {
+            break;
+        }
+        else if (command == "stats") {
+            answers << "stats " << num_jobs << " " << num_failed << " " << t_busy << " " << (t_busy > 0.0 ? num_jobs / t_busy : 0.0) << " " << cache.size() << " " << uptime.elapsedSecondsD() << std::endl;
+        }
+        else if (command == "evict") {
+            std::string target_path;
+            if (!(request >> target_path)) {
+                answers << "error Expected: evict <target>" << std::endl;
+            }
+            else {
+                cache.evict(target_path);
+                answers << "ok" << std::endl;
+            }
+        }
+        else if (command == "embed") {
+            std::string layout_path, target_path, landmarks, algo, output_prefix;
+            if (!(request >> layout_path >> target_path >> landmarks >> algo >> output_prefix)) {
+                answers << "error Expected: embed <layout> <target> <landmarks|-> <algo> <output-prefix>" << std::endl;
+                continue;
+            }
+
+            ++num_jobs;
+            glow::timing::CpuTimer timer;
+            try {
+                const double cost = run_job(cache, layout_path, target_path, landmarks, algo, output_prefix);
+                answers << "ok " << cost << " " << timer.elapsedSecondsD() << " " << output_prefix << ".lem" << std::endl;
+            }
+            catch (const std::exception& e) {
+                ++num_failed;
+                answers << "error " << e.what() << std::endl;
+            }
+            t_busy += timer.elapsedSecondsD();
+        }
+        else {
+            answers << "error Unknown command: " << command << std::endl;
+        }
+    }
+
+    std::cerr << num_jobs << " jobs (" << num_failed << " failed) in " << t_busy << " s busy (" << uptime.elapsedSecondsD() << " s uptime), ";
+    std::cerr << (t_busy > 0.0 ? num_jobs / t_busy : 0.0) << " jobs/s, " << cache.hits << " target cache hits." << std::endl;
+
+    std::cout.rdbuf(answers.rdbuf());
+}
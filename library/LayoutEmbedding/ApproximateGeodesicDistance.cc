@@ -5,34 +5,87 @@
 
 #include <igl/heat_geodesics.h>
 
+#include <exception>
+
 namespace LayoutEmbedding {
 
-pm::vertex_attribute<double> approximate_geodesic_distance(const pm::vertex_attribute<tg::pos3>& _pos, const std::vector<pm::vertex_handle>& _source_vertices)
+struct HeatGeodesicSolver::Data
+{
+    igl::HeatGeodesicsData<double> heat_data;
+};
+
+HeatGeodesicSolver::HeatGeodesicSolver(const pm::vertex_attribute<tg::pos3>& _pos) :
+    data(std::make_unique<Data>()),
+    m(&_pos.mesh())
 {
+    // The IGL mesh is only needed for the precomputation
     IGLMesh im = to_igl_mesh(_pos);
+    igl::heat_geodesics_precompute(im.V, im.F, data->heat_data);
+}
 
-    igl::HeatGeodesicsData<double> data;
-    igl::heat_geodesics_precompute(im.V, im.F, data);
+HeatGeodesicSolver::~HeatGeodesicSolver() = default;
 
+Eigen::VectorXd HeatGeodesicSolver::solve(const std::vector<pm::vertex_handle>& _source_vertices) const
+{
     // Build vector of source vertex indices
     Eigen::VectorXi gamma(_source_vertices.size());
     for (int row = 0; row < gamma.size(); ++row) {
         const auto& v = _source_vertices[row];
-        LE_ASSERT(v.mesh == &_pos.mesh());
+        LE_ASSERT(v.mesh == m);
         gamma[row] = v.idx.value;
     }
 
     Eigen::VectorXd D;
-    igl::heat_geodesics_solve(data, gamma, D);
+    igl::heat_geodesics_solve(data->heat_data, gamma, D);
+    return D;
+}
 
-    const auto& m = _pos.mesh();
-    auto result = m.vertices().make_attribute<double>();
-    for (const auto& v : m.vertices()) {
+pm::vertex_attribute<double> HeatGeodesicSolver::distance(const std::vector<pm::vertex_handle>& _source_vertices) const
+{
+    const Eigen::VectorXd D = solve(_source_vertices);
+
+    auto result = m->vertices().make_attribute<double>();
+    for (const auto& v : m->vertices()) {
         result[v] = D[v.idx.value];
     }
     return result;
 }
 
+pm::vertex_attribute<double> HeatGeodesicSolver::distance(const pm::vertex_handle& _source_vertex) const
+{
+    return distance(std::vector<pm::vertex_handle>{_source_vertex});
+}
+
+Eigen::MatrixXd HeatGeodesicSolver::distances(const std::vector<pm::vertex_handle>& _source_vertices) const
+{
+    const int n = _source_vertices.size();
+    Eigen::MatrixXd result(m->vertices().size(), n);
+    std::vector<std::exception_ptr> exceptions(n);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < n; ++i) {
+        try {
+            result.col(i) = solve({_source_vertices[i]});
+        }
+        catch (...) {
+            exceptions[i] = std::current_exception();
+        }
+    }
+
+    for (const auto& exception : exceptions) {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    return result;
+}
+
+pm::vertex_attribute<double> approximate_geodesic_distance(const pm::vertex_attribute<tg::pos3>& _pos, const std::vector<pm::vertex_handle>& _source_vertices)
+{
+    return HeatGeodesicSolver(_pos).distance(_source_vertices);
+}
+
 pm::vertex_attribute<double> approximate_geodesic_distance(const pm::vertex_attribute<tg::pos3>& _pos, const pm::vertex_handle& _source_vertex)
 {
     return approximate_geodesic_distance(_pos, std::vector<pm::vertex_handle>{_source_vertex});
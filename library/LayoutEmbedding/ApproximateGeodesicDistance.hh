@@ -3,8 +3,40 @@
 #include <polymesh/pm.hh>
 #include <typed-geometry/tg-lean.hh>
 
+#include <Eigen/Dense>
+
+#include <memory>
+
 namespace LayoutEmbedding {
 
+/// Heat method [Crane2013] with precomputed factorizations, for repeated queries on the same mesh.
+/// The mesh (compact) and positions must not change while the solver is in use.
+/// Queries are const and can be issued concurrently.
+class HeatGeodesicSolver
+{
+public:
+    explicit HeatGeodesicSolver(const pm::vertex_attribute<tg::pos3>& _pos);
+    ~HeatGeodesicSolver();
+
+    /// Distance to the closest of the given source vertices.
+    pm::vertex_attribute<double> distance(const std::vector<pm::vertex_handle>& _source_vertices) const;
+    pm::vertex_attribute<double> distance(const pm::vertex_handle& _source_vertex) const;
+
+    /// One column (indexed by vertex index) per source vertex, e.g. one distance field per landmark.
+    /// The columns share the precomputation and are solved in parallel.
+    Eigen::MatrixXd distances(const std::vector<pm::vertex_handle>& _source_vertices) const;
+
+    const pm::Mesh& mesh() const { return *m; }
+
+private:
+    Eigen::VectorXd solve(const std::vector<pm::vertex_handle>& _source_vertices) const;
+
+    struct Data; // Hides libigl
+    std::unique_ptr<Data> data;
+    const pm::Mesh* m;
+};
+
+/// Convenience functions. Use HeatGeodesicSolver for more than one query on the same mesh.
 pm::vertex_attribute<double>
 approximate_geodesic_distance(
     const pm::vertex_attribute<tg::pos3>& _pos,
@@ -0,0 +1,269 @@
+#include "BatchEmbedding.hh"
+
+#include <LayoutEmbedding/VertexRepulsiveEnergy.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <polymesh/formats.hh>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+
+namespace LayoutEmbedding {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(const Clock::time_point& _start)
+{
+    return std::chrono::duration<double>(Clock::now() - _start).count();
+}
+
+bool uses_vertex_repulsive_energy(const BatchEmbeddingSettings& _settings)
+{
+    switch (_settings.algorithm) {
+        case BatchEmbeddingSettings::Algorithm::Greedy:
+            return _settings.greedy_settings.use_vertex_repulsive_tracing;
+        case BatchEmbeddingSettings::Algorithm::Praun:
+            return true;
+        case BatchEmbeddingSettings::Algorithm::BranchAndBound:
+            return _settings.bnb_settings.use_greedy_init; // embed_competitors includes [Praun2001]
+        default:
+            return false;
+    }
+}
+
+/// Rough upper bound on the memory used by a single job: the refined copy of the target mesh with its attributes
+/// and search workspace, once per embedding the algorithm keeps alive at the same time.
+/// With vertex repulsive energies, also the dense energy of the job (one value per target and layout vertex),
+/// once in its embedding and once in the shared energies (which keep at most one per concurrent job).
+double estimate_job_memory(const pm::Mesh& _t_m, const std::vector<BatchLayout>& _layouts, const BatchEmbeddingSettings& _settings)
+{
+    if (_settings.job_memory_estimate > 0.0) {
+        return _settings.job_memory_estimate;
+    }
+
+    constexpr double bytes_per_target_vertex = 2048.0;
+    int num_embeddings = 1;
+    if (_settings.algorithm == BatchEmbeddingSettings::Algorithm::BranchAndBound) {
+        // Working copy, incumbent and the greedy variants of the initialization.
+        num_embeddings = 2 + (_settings.bnb_settings.use_greedy_init ? 8 : 0);
+    }
+    double bytes = bytes_per_target_vertex * _t_m.vertices().size() * num_embeddings;
+
+    if (uses_vertex_repulsive_energy(_settings)) {
+        // Layouts matched by proximity are not counted, their size is only known after loading.
+        std::size_t max_num_landmarks = 0;
+        for (const auto& layout : _layouts) {
+            max_num_landmarks = std::max(max_num_landmarks, layout.landmark_ids.size());
+        }
+        const int num_copies = _settings.share_vertex_repulsive_energy ? 2 : 1;
+        bytes += num_copies * sizeof(double) * _t_m.vertices().size() * max_num_landmarks;
+    }
+    return bytes;
+}
+
+/// Errors are reported per job (see BatchJobResult::error), so they are thrown with their message instead of via LE_ERROR_THROW.
+void load_job_input(const pm::Mesh& _t_m, const pm::vertex_attribute<tg::pos3>& _t_pos, const BatchLayout& _layout, EmbeddingInput& _input)
+{
+    _input.t_m.copy_from(_t_m);
+    _input.t_pos = _input.t_m.vertices().make_attribute<tg::pos3>();
+    _input.t_pos.copy_from(_t_pos);
+
+    if (!pm::load(_layout.layout_path.string(), _input.l_m, _input.l_pos)) {
+        throw std::runtime_error("Could not load layout mesh " + _layout.layout_path.string());
+    }
+    _input.l_matching_vertex = _input.l_m.vertices().make_attribute<pm::vertex_handle>();
+
+    if (_layout.landmark_ids.empty()) {
+        find_matching_vertices_by_proximity(_input);
+        return;
+    }
+
+    if (_layout.landmark_ids.size() != _input.l_m.vertices().size()) {
+        throw std::runtime_error("Wrong number of landmarks.");
+    }
+    for (const auto l_v : _input.l_m.vertices()) {
+        const int t_v_id = _layout.landmark_ids[l_v.idx.value];
+        if (t_v_id < 0 || t_v_id >= (int)_input.t_m.vertices().size()) {
+            throw std::runtime_error("Invalid landmark id " + std::to_string(t_v_id));
+        }
+        _input.l_matching_vertex[l_v] = _input.t_m.vertices()[t_v_id];
+    }
+}
+
+void embed_job(Embedding& _em, const BatchEmbeddingSettings& _settings, BatchJobResult& _result)
+{
+    using Algorithm = BatchEmbeddingSettings::Algorithm;
+
+    if (_settings.algorithm == Algorithm::BranchAndBound) {
+        const auto bnb_result = branch_and_bound(_em, _settings.bnb_settings);
+        _result.cost = bnb_result.cost;
+        _result.insertion_sequence = bnb_result.insertion_sequence;
+        _result.cancelled = bnb_result.cancelled;
+        return;
+    }
+
+    GreedyResult greedy_result;
+    if (_settings.algorithm == Algorithm::Greedy)
+        greedy_result = embed_greedy(_em, _settings.greedy_settings);
+    else if (_settings.algorithm == Algorithm::Praun)
+        greedy_result = embed_praun(_em, _settings.greedy_settings);
+    else if (_settings.algorithm == Algorithm::Kraevoy)
+        greedy_result = embed_kraevoy(_em, _settings.greedy_settings);
+    else if (_settings.algorithm == Algorithm::Schreiner)
+        greedy_result = embed_schreiner(_em, _settings.greedy_settings);
+    _result.cost = greedy_result.cost;
+    _result.insertion_sequence = greedy_result.insertion_sequence;
+    _result.cancelled = greedy_result.cancelled;
+}
+
+}
+
+BatchResult embed_many(
+        const pm::Mesh& _t_m,
+        const pm::vertex_attribute<tg::pos3>& _t_pos,
+        const std::vector<BatchLayout>& _layouts,
+        const BatchEmbeddingSettings& _settings)
+{
+    const auto start_time = Clock::now();
+    const int n = _layouts.size();
+
+    BatchResult result;
+    result.jobs.resize(n);
+    for (int i = 0; i < n; ++i) {
+        result.jobs[i].name = _layouts[i].name;
+    }
+
+    // Bound the number of concurrent jobs by threads and memory
+    int num_concurrent = _settings.num_threads > 0 ? _settings.num_threads : omp_get_max_threads();
+    const double job_memory = estimate_job_memory(_t_m, _layouts, _settings);
+    if (_settings.max_memory > 0.0) {
+        num_concurrent = std::min(num_concurrent, (int)(_settings.max_memory / job_memory));
+    }
+    num_concurrent = std::clamp(num_concurrent, 1, std::max(n, 1));
+    result.num_concurrent_jobs = num_concurrent;
+
+    ProgressReporter progress(&_settings.progress, "embed_many");
+    if (progress.verbose()) {
+        std::cout << "Embedding " << n << " layouts with " << num_concurrent << " concurrent jobs ";
+        std::cout << "(estimated " << job_memory / 1e6 << " MB per job)." << std::endl;
+    }
+
+    // Jobs with identical landmarks run one after another, so their energy is only kept for a short time:
+    // it is dropped after the last of them, and at most one energy per concurrent job is kept.
+    const bool share_vre = _settings.share_vertex_repulsive_energy && uses_vertex_repulsive_energy(_settings);
+    SharedVertexRepulsiveEnergies shared_vre(num_concurrent);
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    if (share_vre) {
+        std::stable_sort(order.begin(), order.end(), [&](int _a, int _b) {
+            return _layouts[_a].landmark_ids < _layouts[_b].landmark_ids;
+        });
+        for (const auto& layout : _layouts) {
+            if (!layout.landmark_ids.empty()) {
+                shared_vre.expect(layout.landmark_ids);
+            }
+        }
+    }
+
+    std::mutex mutex; // Guards progress, num_done and on_embedding
+    int num_done = 0;
+
+    #pragma omp parallel for schedule(dynamic) num_threads(num_concurrent)
+    for (int k = 0; k < n; ++k) {
+        const int i = order[k];
+        auto& job = result.jobs[i];
+        if (progress.cancelled()) {
+            job.cancelled = true;
+            continue;
+        }
+
+        try {
+            // Each job owns its input, since Embedding refers to the layout mesh and creating attributes is not thread-safe.
+            const auto load_start = Clock::now();
+            EmbeddingInput input;
+            load_job_input(_t_m, _t_pos, _layouts[i], input);
+            Embedding em(input);
+            if (share_vre) {
+                shared_vre.apply(em);
+            }
+            job.t_load = seconds_since(load_start);
+
+            const auto embed_start = Clock::now();
+            embed_job(em, _settings, job);
+            job.t_embed = seconds_since(embed_start);
+            job.success = !job.cancelled && em.is_complete();
+            if (!job.success && !job.cancelled) {
+                job.error = "No embedding found.";
+            }
+
+            if (job.success && _settings.on_embedding) {
+                std::lock_guard<std::mutex> lock(mutex);
+                _settings.on_embedding(i, em);
+            }
+        }
+        catch (const std::exception& e) {
+            job.error = e.what();
+        }
+        catch (...) {
+            job.error = "Unknown error";
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++num_done;
+        if (progress.due()) {
+            ProgressSnapshot snapshot;
+            snapshot.num_done = num_done;
+            snapshot.num_total = n;
+            progress.report(snapshot);
+        }
+    }
+
+    // Aggregate statistics
+    result.t_total = seconds_since(start_time);
+    result.num_vertex_repulsive_energies = shared_vre.num_computed();
+    for (const auto& job : result.jobs) {
+        if (job.success) {
+            ++result.num_succeeded;
+            result.t_embed_mean += job.t_embed;
+            result.t_embed_max = std::max(result.t_embed_max, job.t_embed);
+        }
+        else if (job.cancelled) {
+            ++result.num_cancelled;
+        }
+        else {
+            ++result.num_failed;
+        }
+    }
+    if (result.num_succeeded > 0) {
+        result.t_embed_mean /= result.num_succeeded;
+    }
+    if (result.t_total > 0.0) {
+        result.jobs_per_second = result.num_succeeded / result.t_total;
+    }
+
+    {
+        ProgressSnapshot snapshot;
+        snapshot.num_done = num_done;
+        snapshot.num_total = n;
+        progress.report(snapshot, true);
+    }
+
+    if (progress.verbose()) {
+        std::cout << result.num_succeeded << " of " << n << " layouts embedded";
+        std::cout << " (" << result.num_failed << " failed, " << result.num_cancelled << " cancelled)";
+        std::cout << " in " << result.t_total << " s, " << result.jobs_per_second << " jobs/s." << std::endl;
+        std::cout << "Embedding time per job: mean " << result.t_embed_mean << " s, max " << result.t_embed_max << " s." << std::endl;
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <LayoutEmbedding/BranchAndBound.hh>
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/EmbeddingInput.hh>
+#include <LayoutEmbedding/Greedy.hh>
+#include <LayoutEmbedding/Progress.hh>
+
+namespace LayoutEmbedding {
+
+/// A layout to be embedded into the shared target mesh of a batch.
+struct BatchLayout
+{
+    std::string name;
+    fs::path layout_path;
+
+    /// Target vertex id of each layout vertex (in layout vertex order).
+    /// If empty, layout vertices are matched to the closest target vertices.
+    std::vector<int> landmark_ids;
+};
+
+struct BatchEmbeddingSettings
+{
+    enum class Algorithm
+    {
+        Greedy,
+        Praun,
+        Kraevoy,
+        Schreiner,
+        BranchAndBound,
+    };
+    Algorithm algorithm = Algorithm::Greedy;
+    GreedySettings greedy_settings;
+    BranchAndBoundSettings bnb_settings;
+
+    /// Maximum number of jobs running at the same time. Set to <= 0 to use all OpenMP threads.
+    int num_threads = 0;
+
+    /// Bytes. Further limits the number of concurrent jobs by their estimated memory footprint.
+    /// Set to <= 0 to disable.
+    double max_memory = 8e9;
+
+    /// Bytes per job. Set to <= 0 to estimate from the size of the target mesh and the algorithm.
+    double job_memory_estimate = 0.0;
+
+    /// Compute the vertex repulsive energy [Praun2001] once per distinct set of landmarks
+    /// instead of once per job (if the algorithm requires it).
+    /// Only energies of layouts with landmark_ids are counted in the memory estimate and dropped after their last job.
+    /// Others are kept until more than one per concurrent job would be kept.
+    bool share_vertex_repulsive_energy = true;
+
+    /// Called (never concurrently) with each successfully completed embedding, e.g. to save it.
+    std::function<void(int _job, const Embedding& _em)> on_embedding;
+
+    /// Reports the number of finished jobs. Cancellation skips all jobs that have not started yet.
+    /// The observers in greedy_settings / bnb_settings are passed to the individual jobs.
+    ProgressObserver progress;
+};
+
+struct BatchJobResult
+{
+    std::string name;
+    bool success = false;
+    bool cancelled = false;
+    std::string error; // Set if the job threw an exception
+
+    double cost = std::numeric_limits<double>::infinity();
+    InsertionSequence insertion_sequence;
+
+    double t_load = 0.0; // Seconds, including the copy of the target mesh
+    double t_embed = 0.0; // Seconds
+};
+
+struct BatchResult
+{
+    std::vector<BatchJobResult> jobs;
+
+    int num_succeeded = 0;
+    int num_failed = 0;
+    int num_cancelled = 0;
+
+    int num_concurrent_jobs = 0;
+    int num_vertex_repulsive_energies = 0; // Computed (and shared) vertex repulsive energies, including dropped ones
+
+    double t_total = 0.0; // Seconds, wall clock
+    double t_embed_mean = 0.0; // Seconds per successful job
+    double t_embed_max = 0.0;
+    double jobs_per_second = 0.0;
+};
+
+/// Embeds each of _layouts into its own copy of the target mesh (_t_m, _t_pos), running up to
+/// settings.num_threads jobs in parallel. Jobs with identical landmarks share their vertex repulsive energy.
+/// Failing jobs do not affect the others. Their error is reported in the respective BatchJobResult.
+BatchResult embed_many(
+        const pm::Mesh& _t_m,
+        const pm::vertex_attribute<tg::pos3>& _t_pos,
+        const std::vector<BatchLayout>& _layouts,
+        const BatchEmbeddingSettings& _settings = BatchEmbeddingSettings());
+
+}
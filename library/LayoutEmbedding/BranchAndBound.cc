@@ -4,11 +4,14 @@
 #include <LayoutEmbedding/EmbeddingState.hh>
 #include <LayoutEmbedding/GetQueueContainer.hh>
 #include <LayoutEmbedding/Greedy.hh>
+#include <LayoutEmbedding/LocalSearch.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
 
 #include <glow-extras/timing/CpuTimer.hh>
 
 #include <chrono>
+#include <cmath>
+#include <optional>
 #include <queue>
 
 namespace LayoutEmbedding {
@@ -21,6 +24,7 @@ struct State
     VirtualPath path;
     std::vector<VirtualPath> candidate_paths;
     std::set<std::pair<pm::edge_index, pm::edge_index>> candidate_conflicts;
+    EmbeddingState::ConflictPenalties conflict_penalties;
 };
 
 struct Candidate
@@ -39,10 +43,17 @@ struct Candidate
 BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettings& _settings, const std::string& _name)
 {
     glow::timing::CpuTimer timer;
+    ProgressReporter progress(&_settings.progress, _name);
+    const bool verbose = progress.verbose();
 
     BranchAndBoundResult result(_name, _settings);
 
+    // The incumbent is either a complete embedding (greedy initialization, local search), which is applied as is,
+    // or a conflict-free state of the search tree (best_state), which is only completed once at the end.
+    // global_upper_bound is the cost of the incumbent. For a state, this is its lower bound, i.e. the cost of its candidate paths.
     InsertionSequence best_insertion_sequence;
+    std::optional<Embedding> best_embedding;
+    std::optional<HashValue> best_state;
     double global_upper_bound = std::numeric_limits<double>::infinity();
 
     if (_settings.record_lower_bound_events) {
@@ -59,31 +70,116 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
         result.upper_bound_events.push_back(event);
     }
 
+    auto improve_upper_bound = [&](Embedding& _em_complete) {
+        if (_settings.use_local_search_for_upper_bounds) {
+            LocalSearchSettings local_search_settings;
+            local_search_settings.progress.verbose = verbose;
+            local_search_settings.progress.cancellation_token = _settings.progress.cancellation_token;
+            improve_embedding(_em_complete, local_search_settings);
+        }
+    };
+
     // Run heuristic algorithm to find a tighter initial upper bound.
     if (_settings.use_greedy_init) {
         Embedding em(_em);
-        const auto results = embed_competitors(em);
-        global_upper_bound = em.total_embedded_path_length();
-        best_insertion_sequence = best(results).insertion_sequence;
+        GreedySettings greedy_settings;
+        greedy_settings.progress.verbose = verbose;
+        greedy_settings.progress.cancellation_token = _settings.progress.cancellation_token;
+        auto results = embed_competitors(em, greedy_settings);
+        if (_settings.greedy_init_restarts > 0) {
+            Embedding em_randomized(_em);
+            greedy_settings.restricted_candidate_list_size = _settings.greedy_init_restricted_candidate_list_size;
+            const auto randomized_results = embed_greedy_restarts(em_randomized, greedy_settings, _settings.greedy_init_restarts, _settings.greedy_init_time_limit);
+            const auto& best_randomized_result = best(randomized_results);
+            if (!best_randomized_result.cancelled && best_randomized_result.cost < best(results).cost) {
+                em = em_randomized;
+                results.push_back(best_randomized_result);
+            }
+        }
+        const auto& best_result = best(results);
+        if (!best_result.cancelled && std::isfinite(best_result.cost)) { // Otherwise no incumbent
+            improve_upper_bound(em);
+            global_upper_bound = em.total_embedded_path_length();
+            best_insertion_sequence = best_result.insertion_sequence;
+            best_embedding = em;
+
+            if (_settings.record_upper_bound_events) {
+                BranchAndBoundResult::UpperBoundEvent event;
+                event.t = timer.elapsedSecondsD();
+                event.upper_bound = global_upper_bound;
+                result.upper_bound_events.push_back(event);
+            }
+        }
+    }
+
+    EmbeddingState::ReroutedLengths rerouted_lengths;
+    result.exact = !(_settings.use_candidate_paths_for_lower_bounds && _settings.use_conflict_penalty_heuristic);
+
+    std::map<HashValue, State> known_states;
 
+    // Embedding of a state, obtained by inserting the stored paths along the state tree.
+    auto replay_state = [&](const HashValue _state_hash, InsertionSequence& _insertion_sequence) {
+        std::vector<const VirtualPath*> paths;
+        _insertion_sequence.clear();
+        for (HashValue h = _state_hash; h != 0; h = known_states.at(h).parent) {
+            _insertion_sequence.push_back(known_states.at(h).l_e);
+            paths.push_back(&known_states.at(h).path);
+        }
+        std::reverse(_insertion_sequence.begin(), _insertion_sequence.end());
+        std::reverse(paths.begin(), paths.end());
+
+        Embedding em(_em);
+        for (size_t i = 0; i < _insertion_sequence.size(); ++i) {
+            em.embed_path(em.layout_mesh().edges()[_insertion_sequence[i]].halfedgeA(), *paths[i]);
+        }
+        return em;
+    };
+
+    // Embeds the remaining edges of a conflict-free state via its candidate paths.
+    // Conflict-free candidate paths do not share any target vertices, edges or faces, so inserting one
+    // (which only splits its own edges and faces) leaves the others valid. The resulting cost is the
+    // lower bound of the state. This is done once per improving state if use_local_search_for_upper_bounds
+    // is set, otherwise only once for the final incumbent.
+    // Returns false if a candidate path is missing (the state is incomplete).
+    auto complete_state = [&](Embedding& _em_state, const std::vector<VirtualPath>& _candidate_paths, InsertionSequence& _insertion_sequence) {
+        for (const auto l_e : _em_state.layout_mesh().edges()) {
+            if (!_em_state.is_embedded(l_e)) {
+                const auto& path = _candidate_paths[l_e.idx.value];
+                if (path.empty()) {
+                    return false;
+                }
+                _em_state.embed_path(l_e.halfedgeA(), path);
+                _insertion_sequence.push_back(l_e);
+            }
+        }
+        return _em_state.is_complete();
+    };
+
+    auto record_upper_bound = [&]() {
+        if (verbose) {
+            std::cout << "New upper bound: " << global_upper_bound << std::endl;
+        }
         if (_settings.record_upper_bound_events) {
             BranchAndBoundResult::UpperBoundEvent event;
             event.t = timer.elapsedSecondsD();
             event.upper_bound = global_upper_bound;
             result.upper_bound_events.push_back(event);
         }
-    }
-
-    std::map<HashValue, State> known_states;
+    };
     {
         EmbeddingState es(_em, _settings);
+        es.rerouted_lengths = &rerouted_lengths;
         es.compute_all_candidate_paths();
         es.detect_candidate_path_conflicts();
+        if (_settings.use_conflict_penalty_heuristic) {
+            es.compute_conflict_penalties();
+        }
 
         State root;
         root.parent = 0;
         root.candidate_paths = es.candidate_paths.to_vector();
         root.candidate_conflicts = es.conflicts;
+        root.conflict_penalties = es.conflict_penalties;
 
         known_states[0] = root;
     }
@@ -102,6 +198,14 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
     while (!q.empty()) {
         ++iter;
 
+        if (progress.cancelled()) {
+            if (verbose) {
+                std::cout << "Branch-and-bound was cancelled." << std::endl;
+            }
+            result.cancelled = true;
+            break;
+        }
+
         // Time limit
         if (_settings.time_limit > 0.0) {
             if (timer.elapsedSecondsD() >= _settings.time_limit) {
@@ -111,9 +215,11 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
                 }
 
                 if (should_terminate) {
-                    std::cout << "Reached time limit of " << _settings.time_limit << " s. Terminating." << std::endl;
-                    if (std::isinf(global_upper_bound)) {
-                        std::cout << "Warning: No valid solution was found within that time." << std::endl;
+                    if (verbose) {
+                        std::cout << "Reached time limit of " << _settings.time_limit << " s. Terminating." << std::endl;
+                        if (std::isinf(global_upper_bound)) {
+                            std::cout << "Warning: No valid solution was found within that time." << std::endl;
+                        }
                     }
                     break;
                 }
@@ -145,6 +251,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
 
         // Reconstruct the embedding associated with this state
         EmbeddingState es(_em, _settings);
+        es.rerouted_lengths = &rerouted_lengths;
         LE_ASSERT_EQ(insertion_sequence.size(), inserted_paths.size());
         for (size_t i = 0; i < insertion_sequence.size(); ++i) {
             const pm::edge_index& l_e = insertion_sequence[i];
@@ -163,6 +270,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
 
         // Reconstruct candidate conflicts
         es.conflicts = state.candidate_conflicts;
+        es.conflict_penalties = state.conflict_penalties;
 
         if (!es.valid()) {
             // The current embedding might be invalid if paths run into dead ends.
@@ -180,31 +288,44 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
         const auto& es_conflicting_edges = es.conflicting_edges();
         const auto& es_non_conflicting_edges = es.non_conflicting_edges();
 
-        std::cout << "t: " << timer.elapsedSecondsD();
-        std::cout << "    ";
-        std::cout << "global UB: " << global_upper_bound;
-        std::cout << "    ";
-        std::cout << "local LB: " << es.cost_lower_bound();
-        std::cout << "    ";
-        std::cout << "local gap: " << (gap * 100.0) << " %";
-        std::cout << "    ";
-        std::cout << "|Embd|: " << es_embedded_edges.size();
-        std::cout << "    ";
-        std::cout << "|Conf|: " << es_conflicting_edges.size();
-        std::cout << "    ";
-        std::cout << "|Ncnf|: " << es_non_conflicting_edges.size();
-        std::cout << "    ";
-        std::cout << "|Q|: " << q.size();
-        std::cout << "    ";
-        std::cout << "|H|: " << known_states.size();
-        if (_settings.print_current_insertion_sequence) {
+        if (progress.due()) {
+            ProgressSnapshot snapshot;
+            snapshot.iteration = iter;
+            snapshot.num_done = es_embedded_edges.size();
+            snapshot.num_total = es.em.layout_mesh().edges().size();
+            snapshot.upper_bound = global_upper_bound;
+            snapshot.lower_bound = es.cost_lower_bound();
+            snapshot.queue_size = q.size();
+            progress.report(snapshot);
+        }
+
+        if (verbose) {
+            std::cout << "t: " << timer.elapsedSecondsD();
+            std::cout << "    ";
+            std::cout << "global UB: " << global_upper_bound;
+            std::cout << "    ";
+            std::cout << "local LB: " << es.cost_lower_bound();
+            std::cout << "    ";
+            std::cout << "local gap: " << (gap * 100.0) << " %";
+            std::cout << "    ";
+            std::cout << "|Embd|: " << es_embedded_edges.size();
             std::cout << "    ";
-            std::cout << "s: ";
-            for (const auto& label : insertion_sequence) {
-                std::cout << label.value << " ";
+            std::cout << "|Conf|: " << es_conflicting_edges.size();
+            std::cout << "    ";
+            std::cout << "|Ncnf|: " << es_non_conflicting_edges.size();
+            std::cout << "    ";
+            std::cout << "|Q|: " << q.size();
+            std::cout << "    ";
+            std::cout << "|H|: " << known_states.size();
+            if (_settings.print_current_insertion_sequence) {
+                std::cout << "    ";
+                std::cout << "s: ";
+                for (const auto& label : insertion_sequence) {
+                    std::cout << label.value << " ";
+                }
             }
+            std::cout << std::endl;
         }
-        std::cout << std::endl;
 
         if (_settings.record_lower_bound_events && !q.empty()) {
             double min_lower_bound = std::numeric_limits<double>::infinity();
@@ -225,10 +346,10 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
             }
         }
 
-        if (_settings.print_memory_footprint_estimate) {
+        if ((_settings.print_memory_footprint_estimate && verbose) || _settings.record_memory_footprint_estimate) {
             if (iter % 50 == 0) {
                 // Memory estimate
-                double estimated_memory;
+                double estimated_memory = 0.0;
 
                 // Estimate memory of queue
                 estimated_memory += q.size() * sizeof (Candidate);
@@ -256,20 +377,22 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
 
                 result.max_state_tree_memory_estimate = std::max(result.max_state_tree_memory_estimate, estimated_memory);
 
-                std::cout << "State tree memory estimate: ";
-                if (estimated_memory > 1000000000.0) {
-                    std::cout << (estimated_memory / 1000000000.0) << " GB";
-                }
-                else if (estimated_memory > 1000000.0) {
-                    std::cout << (estimated_memory / 1000000.0) << " MB";
-                }
-                else if (estimated_memory > 1000.0) {
-                    std::cout << (estimated_memory / 1000.0) << " kB";
-                }
-                else {
-                    std::cout << (estimated_memory) << " B";
+                if (verbose && _settings.print_memory_footprint_estimate) {
+                    std::cout << "State tree memory estimate: ";
+                    if (estimated_memory > 1000000000.0) {
+                        std::cout << (estimated_memory / 1000000000.0) << " GB";
+                    }
+                    else if (estimated_memory > 1000000.0) {
+                        std::cout << (estimated_memory / 1000000.0) << " MB";
+                    }
+                    else if (estimated_memory > 1000.0) {
+                        std::cout << (estimated_memory / 1000.0) << " kB";
+                    }
+                    else {
+                        std::cout << (estimated_memory) << " B";
+                    }
+                    std::cout << std::endl;
                 }
-                std::cout << std::endl;
             }
         }
 
@@ -284,14 +407,30 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
 
             // Completed layout?
             if (insertion_options.empty()) {
-                global_upper_bound = es.cost_lower_bound();
-                best_insertion_sequence = insertion_sequence;
-                std::cout << "New upper bound: " << global_upper_bound << std::endl;
-                if (_settings.record_upper_bound_events) {
-                    BranchAndBoundResult::UpperBoundEvent event;
-                    event.t = timer.elapsedSecondsD();
-                    event.upper_bound = global_upper_bound;
-                    result.upper_bound_events.push_back(event);
+                if (_settings.use_local_search_for_upper_bounds) {
+                    // Local search requires the complete embedding
+                    Embedding complete_em(es.em);
+                    InsertionSequence complete_insertion_sequence = insertion_sequence;
+                    if (complete_state(complete_em, state.candidate_paths, complete_insertion_sequence)) {
+                        improve_upper_bound(complete_em);
+                    }
+                    const double complete_cost = complete_em.is_complete() ? complete_em.total_embedded_path_length() : std::numeric_limits<double>::infinity();
+                    if (complete_cost < global_upper_bound) {
+                        global_upper_bound = complete_cost;
+                        best_insertion_sequence = complete_insertion_sequence;
+                        best_embedding = complete_em;
+                        best_state.reset();
+                        record_upper_bound();
+                    }
+                }
+                else {
+                    // The remaining candidate paths are free of conflicts, so the lower bound is the cost of this solution.
+                    const double state_cost = es.cost_lower_bound();
+                    if (state_cost < global_upper_bound) {
+                        global_upper_bound = state_cost;
+                        best_state = c.state_hash;
+                        record_upper_bound();
+                    }
                 }
             }
             else {
@@ -317,13 +456,16 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
                     //}
 
                     // Update candidate paths that were in conflict with the newly inserted edge
+                    std::set<pm::edge_index> recomputed_candidates;
                     for (const auto& l_e_conflicting : new_es.get_conflicting_candidates(l_e)) {
                         new_es.compute_candidate_path(l_e_conflicting);
+                        recomputed_candidates.insert(l_e_conflicting);
                     }
 
-                    // Pruning
-                    const double new_lower_bound = new_es.cost_lower_bound();
-                    const double new_gap = 1.0 - new_lower_bound / global_upper_bound;
+                    // Pruning (conflict penalties are not available yet and are treated as zero)
+                    new_es.conflict_penalties.clear();
+                    double new_lower_bound = new_es.cost_lower_bound();
+                    double new_gap = 1.0 - new_lower_bound / global_upper_bound;
                     if (new_gap < _settings.optimality_gap) {
                         continue;
                     }
@@ -331,6 +473,17 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
                     // Recompute all conflicts
                     new_es.detect_candidate_path_conflicts();
 
+                    if (_settings.use_conflict_penalty_heuristic) {
+                        new_es.compute_conflict_penalties(&state.conflict_penalties, recomputed_candidates);
+
+                        // Pruning with the tightened bound
+                        new_lower_bound = new_es.cost_lower_bound();
+                        new_gap = 1.0 - new_lower_bound / global_upper_bound;
+                        if (new_gap < _settings.optimality_gap) {
+                            continue;
+                        }
+                    }
+
                     // Create a new state
                     State new_state;
                     new_state.parent = c.state_hash;
@@ -338,6 +491,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
                     new_state.path = es.candidate_paths[l_e];
                     new_state.candidate_paths = new_es.candidate_paths.to_vector();
                     new_state.candidate_conflicts = new_es.conflicts;
+                    new_state.conflict_penalties = new_es.conflict_penalties;
 
                     // Save the new state
                     known_states.emplace(new_es_hash, new_state);
@@ -361,8 +515,9 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
             }
         }
     }
-    std::cout << "Branch-and-bound optimization completed." << std::endl;
-    result.insertion_sequence = best_insertion_sequence;
+    if (verbose) {
+        std::cout << "Branch-and-bound optimization completed." << std::endl;
+    }
     result.num_iters = iter;
 
     {
@@ -379,42 +534,57 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
             final_lower_bound = global_upper_bound * (1.0 - _settings.optimality_gap);
             final_gap = _settings.optimality_gap;
         }
-        std::cout << "The optimal solution is at most " << (final_gap * 100.0) << " % better than the found solution." << std::endl;
+        if (verbose) {
+            if (result.exact) {
+                std::cout << "The optimal solution is at most " << (final_gap * 100.0) << " % better than the found solution." << std::endl;
+            }
+            else {
+                std::cout << "Estimated gap to the optimal solution: " << (final_gap * 100.0) << " % (no guarantee, the conflict penalty heuristic was used)." << std::endl;
+            }
+        }
 
         result.lower_bound = final_lower_bound;
         result.gap = final_gap;
     }
 
-    if (std::isinf(global_upper_bound)) {
-        result.cost = global_upper_bound;
+    if (best_state) {
+        // Complete the best state. Keep the previous complete incumbent (if any) if that turns out cheaper.
+        InsertionSequence state_insertion_sequence;
+        Embedding state_em = replay_state(*best_state, state_insertion_sequence);
+        if (complete_state(state_em, known_states.at(*best_state).candidate_paths, state_insertion_sequence)) {
+            const double state_cost = state_em.total_embedded_path_length();
+            if (!best_embedding || state_cost < best_embedding->total_embedded_path_length()) {
+                best_embedding = state_em;
+                best_insertion_sequence = state_insertion_sequence;
+            }
+        }
+        else if (verbose) {
+            std::cout << "Warning: The best state could not be completed." << std::endl;
+        }
+    }
+
+    if (!best_embedding) {
+        result.cost = std::numeric_limits<double>::infinity();
         result.insertion_sequence.clear();
     }
     else {
-        // Apply the victorious embedding sequence to the input embedding
-        // Edges with predefined insertion sequence
-        std::set<pm::edge_index> l_e_embedded;
-        result.insertion_sequence.clear();
-        for (const auto& l_ei : best_insertion_sequence) {
-            const auto l_e = _em.layout_mesh().edges()[l_ei];
-            const auto l_he = l_e.halfedgeA();
-            const auto path = _em.find_shortest_path(l_he);
-            _em.embed_path(l_he, path);
-            l_e_embedded.insert(l_e);
-            result.insertion_sequence.push_back(l_e);
-        }
-        // Remaining edges
-        for (const auto l_e : _em.layout_mesh().edges()) {
-            if (!l_e_embedded.count(l_e)) {
-                const auto l_he = l_e.halfedgeA();
-                const auto path = _em.find_shortest_path(l_he);
-                _em.embed_path(l_he, path);
-                l_e_embedded.insert(l_e);
-                result.insertion_sequence.push_back(l_e);
-            }
-        }
+        // Apply the victorious embedding to the input embedding
+        LE_ASSERT(best_embedding->is_complete());
+        _em = *best_embedding;
+        result.insertion_sequence = best_insertion_sequence;
         result.cost = _em.total_embedded_path_length();
     }
 
+    {
+        ProgressSnapshot snapshot;
+        snapshot.iteration = iter;
+        snapshot.num_done = _em.layout_mesh().edges().size();
+        snapshot.num_total = _em.layout_mesh().edges().size();
+        snapshot.upper_bound = result.cost;
+        snapshot.lower_bound = result.lower_bound;
+        progress.report(snapshot, true);
+    }
+
     return result;
 }
 
@@ -2,6 +2,7 @@
 
 #include <LayoutEmbedding/Embedding.hh>
 #include <LayoutEmbedding/InsertionSequence.hh>
+#include <LayoutEmbedding/Progress.hh>
 
 namespace LayoutEmbedding {
 
@@ -25,10 +26,38 @@ struct BranchAndBoundSettings
     bool use_proactive_pruning = true;
     bool use_candidate_paths_for_lower_bounds = true;
 
+    /// Non-exact pruning heuristic: Increase lower bounds by an estimated cost of resolving conflicts among pairs of candidate paths.
+    /// For each conflicting pair, both insertion orders are evaluated, keeping the first path and rerouting the second one around it.
+    /// Penalties of disjoint pairs are summed via a greedy maximum-weight matching on the conflict graph.
+    /// The estimate is not admissible: a completion can also detour the first path and thereby free the second one,
+    /// which can cost less than the penalty. With this option, the optimal solution may be pruned and
+    /// BranchAndBoundResult::lower_bound and gap are estimates (see BranchAndBoundResult::exact).
+    /// Only has an effect if use_candidate_paths_for_lower_bounds is set.
+    bool use_conflict_penalty_heuristic = false;
+
     bool print_current_insertion_sequence = true;
+
+    /// Estimating the memory footprint walks all known states (every 50 iterations).
+    /// Printing only takes effect if the progress observer is verbose.
     bool print_memory_footprint_estimate = true;
+    /// Also estimate it in silent mode, to report BranchAndBoundResult::max_state_tree_memory_estimate.
+    bool record_memory_footprint_estimate = false;
+
+    /// Progress callbacks, cancellation and console output.
+    /// On cancellation, the best solution found so far (if any) is applied.
+    ProgressObserver progress;
 
     bool use_greedy_init = true;
+
+    /// If > 0, the greedy initialization additionally runs this many randomized restarts (see embed_greedy_restarts)
+    /// within greedy_init_time_limit seconds and keeps the best upper bound.
+    int greedy_init_restarts = 0;
+    int greedy_init_restricted_candidate_list_size = 3;
+    double greedy_init_time_limit = 10.0;
+
+    /// Shorten the initial greedy solution and every new incumbent with improve_embedding (see LocalSearch.hh)
+    /// before using it as upper bound. The reported insertion sequence then reproduces the embedding only up to these improvements.
+    bool use_local_search_for_upper_bounds = false;
 };
 
 struct BranchAndBoundResult
@@ -49,6 +78,10 @@ struct BranchAndBoundResult
     double lower_bound = std::numeric_limits<double>::infinity();
     double gap = 1.0;
 
+    /// False if a non-exact pruning heuristic was used (see BranchAndBoundSettings::use_conflict_penalty_heuristic).
+    /// Then lower_bound and gap are no guarantees.
+    bool exact = true;
+
     struct UpperBoundEvent
     {
         double t;
@@ -63,8 +96,9 @@ struct BranchAndBoundResult
     };
     std::vector<LowerBoundEvent> lower_bound_events;
 
-    double max_state_tree_memory_estimate = 0.0; // Bytes
+    double max_state_tree_memory_estimate = 0.0; // Bytes. Only if estimated (see print_/record_memory_footprint_estimate)
     int num_iters = 0;
+    bool cancelled = false;
 };
 
 BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettings& _settings = BranchAndBoundSettings(), const std::string& _name = "bnb");
@@ -1,6 +1,7 @@
 ﻿#include "Embedding.hh"
 
 #include <LayoutEmbedding/Connectivity.hh>
+#include <LayoutEmbedding/SearchRegion.hh>
 #include <LayoutEmbedding/VertexRepulsiveEnergy.hh>
 #include <LayoutEmbedding/VirtualVertexAttribute.hh>
 #include <LayoutEmbedding/Snake.hh>
@@ -41,7 +42,27 @@ Embedding::Embedding(const Embedding& _em)
 
 Embedding& Embedding::operator=(const Embedding& _em)
 {
-    input = _em.input;
+    copy_from(_em, _em.input);
+    return *this;
+}
+
+Embedding::Embedding(const Embedding& _em, EmbeddingInput& _input)
+{
+    LE_ASSERT_EQ(_input.l_m.all_vertices().size(), _em.layout_mesh().all_vertices().size());
+    LE_ASSERT_EQ(_input.l_m.all_halfedges().size(), _em.layout_mesh().all_halfedges().size());
+    copy_from(_em, &_input);
+}
+
+void Embedding::assign_keep_input(const Embedding& _em)
+{
+    LE_ASSERT_EQ(input->l_m.all_vertices().size(), _em.layout_mesh().all_vertices().size());
+    LE_ASSERT_EQ(input->l_m.all_halfedges().size(), _em.layout_mesh().all_halfedges().size());
+    copy_from(_em, input);
+}
+
+void Embedding::copy_from(const Embedding& _em, EmbeddingInput* _input)
+{
+    input = _input;
     t_m.copy_from(_em.t_m);
 
     t_pos = t_m.vertices().make_attribute<tg::pos3>();
@@ -62,12 +83,14 @@ Embedding& Embedding::operator=(const Embedding& _em)
         t_matching_halfedge[t_he] = layout_mesh()[_em.t_matching_halfedge[t_he.idx].idx];
     }
 
+    vre_settings = _em.vre_settings;
     if (_em.vertex_repulsive_energy.has_value()) {
-        vertex_repulsive_energy = target_mesh().vertices().make_attribute<Eigen::VectorXd>();
+        vertex_repulsive_energy = target_mesh().vertices().make_attribute<VertexRepulsiveEnergyRow>();
         vertex_repulsive_energy->copy_from(*_em.vertex_repulsive_energy);
     }
-
-    return *this;
+    else {
+        vertex_repulsive_energy.reset();
+    }
 }
 
 pm::halfedge_handle Embedding::get_embedded_target_halfedge(const pm::halfedge_handle& _l_he) const
@@ -266,7 +289,7 @@ tg::pos3 Embedding::element_pos(const VirtualVertex& _t_vv) const
     }
 }
 
-VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector_start, const pm::halfedge_handle& _t_h_sector_end, ShortestPathMetric _metric) const
+VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector_start, const pm::halfedge_handle& _t_h_sector_end, ShortestPathMetric _metric, std::vector<VirtualVertex>* _explored, const std::function<bool(const VirtualVertex&)>& _is_in_region) const
 {
     struct Distance
     {
@@ -295,8 +318,10 @@ VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector
     LE_ASSERT(_t_h_sector_start.mesh == &target_mesh());
     LE_ASSERT(_t_h_sector_end.mesh == &target_mesh());
 
-    VirtualVertexAttribute<VirtualVertex> prev(target_mesh());
-    VirtualVertexAttribute<Distance> distance(target_mesh());
+    // Restricted searches only touch a small part of the mesh
+    const bool sparse = (bool)_is_in_region;
+    VirtualVertexAttribute<VirtualVertex> prev(target_mesh(), sparse);
+    VirtualVertexAttribute<Distance> distance(target_mesh(), sparse);
 
     const pm::vertex_handle t_v_start = _t_h_sector_start.vertex_from();
     const pm::vertex_handle t_v_end   = _t_h_sector_end.vertex_from();
@@ -373,6 +398,9 @@ VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector
             if (is_blocked(to)) {
                 return false;
             }
+            if (_is_in_region && !_is_in_region(to)) {
+                return false;
+            }
         }
 
         return true;
@@ -426,6 +454,10 @@ VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector
 
         const auto& vv = u.vv;
 
+        if (_explored) {
+            _explored->push_back(vv);
+        }
+
         // Expand vertex neighborhood
         if (is_real_vertex(vv)) {
             const auto& t_v = real_vertex(u.vv, target_mesh());
@@ -494,6 +526,31 @@ VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector
     }
 }
 
+VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector_start, const pm::halfedge_handle& _t_h_sector_end, const SearchRegion& _region, ShortestPathMetric _metric, int* _num_widenings) const
+{
+    SearchRegion region = _region;
+    for (int i = 0; i <= _region.max_widenings; ++i) {
+        if (_num_widenings) {
+            *_num_widenings = i;
+        }
+        const auto path = find_shortest_path(_t_h_sector_start, _t_h_sector_end, _metric, nullptr, [&](const VirtualVertex& _vv) {
+            return region.contains(*this, _vv);
+        });
+        if (!path.empty()) {
+            return path;
+        }
+        region = region.widened(*this);
+    }
+
+    if (!_region.fall_back_to_unrestricted) {
+        return {};
+    }
+    if (_num_widenings) {
+        *_num_widenings = _region.max_widenings + 1;
+    }
+    return find_shortest_path(_t_h_sector_start, _t_h_sector_end, _metric);
+}
+
 VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _l_he, ShortestPathMetric _metric) const
 {
     LE_ASSERT(_l_he.mesh == &layout_mesh());
@@ -546,8 +603,7 @@ void Embedding::embed_path(const pm::halfedge_handle& _l_he, const VirtualPath&
             t_pos[t_v_new] = p;
 
             if (vertex_repulsive_energy.has_value()) {
-                Eigen::VectorXd vre = 0.5 * (*vertex_repulsive_energy)[t_vA] + 0.5 * (*vertex_repulsive_energy)[t_vB];
-                (*vertex_repulsive_energy)[t_v_new] = vre;
+                (*vertex_repulsive_energy)[t_v_new] = VertexRepulsiveEnergyRow::midpoint((*vertex_repulsive_energy)[t_vA], (*vertex_repulsive_energy)[t_vB]);
             }
 
             vertex_path.push_back(t_v_new);
@@ -793,22 +849,91 @@ pm::halfedge_handle& Embedding::matching_layout_halfedge(const pm::halfedge_hand
     return t_matching_halfedge[_t_h];
 }
 
-double Embedding::get_vertex_repulsive_energy(const pm::vertex_handle& _t_v, const pm::vertex_handle& _l_v) const
+void Embedding::set_matching_target_vertex(const pm::vertex_handle& _l_v, const pm::vertex_handle& _t_v)
 {
+    LE_ASSERT(_l_v.mesh == &layout_mesh());
     LE_ASSERT(_t_v.mesh == &target_mesh());
+    for (const auto l_he : _l_v.outgoing_halfedges()) {
+        LE_ASSERT(!is_embedded(l_he));
+    }
+    LE_ASSERT(!is_blocked(_t_v));
+    LE_ASSERT(!_t_v.is_boundary());
+
+    const auto t_v_old = l_matching_vertex[_l_v];
+    if (t_v_old.is_valid()) {
+        t_matching_vertex[t_v_old] = pm::vertex_handle::invalid;
+    }
+    l_matching_vertex[_l_v] = _t_v;
+    t_matching_vertex[_t_v] = _l_v;
+
+    vertex_repulsive_energy.reset();
+}
+
+void Embedding::unmatch_layout_vertex(const pm::vertex_handle& _l_v)
+{
     LE_ASSERT(_l_v.mesh == &layout_mesh());
+    for (const auto l_he : _l_v.outgoing_halfedges()) {
+        LE_ASSERT(!is_embedded(l_he));
+    }
 
-    if (!vertex_repulsive_energy.has_value()) {
-        Eigen::MatrixXd vre = compute_vertex_repulsive_energy(*this);
-        vertex_repulsive_energy = target_mesh().vertices().make_attribute<Eigen::VectorXd>();
-        for (const auto t_v : target_mesh().vertices()) {
-            (*vertex_repulsive_energy)[t_v] = vre.row(t_v.idx.value);
-        }
+    const auto t_v = l_matching_vertex[_l_v];
+    if (t_v.is_valid()) {
+        t_matching_vertex[t_v] = pm::vertex_handle::invalid;
     }
+    l_matching_vertex[_l_v] = pm::vertex_handle::invalid;
+
+    vertex_repulsive_energy.reset();
+}
+
+double Embedding::get_vertex_repulsive_energy(const pm::vertex_handle& _t_v, const pm::vertex_handle& _l_v) const
+{
+    LE_ASSERT(_t_v.mesh == &target_mesh());
+    LE_ASSERT(_l_v.mesh == &layout_mesh());
+
+    prepare_vertex_repulsive_energy();
     LE_ASSERT(vertex_repulsive_energy.has_value());
     return (*vertex_repulsive_energy)[_t_v][_l_v.idx.value];
 }
 
+namespace
+{
+
+pm::vertex_attribute<VertexRepulsiveEnergyRow> vertex_repulsive_energy_attribute(const pm::Mesh& _t_m, const Eigen::MatrixXd& _vre, const VertexRepulsiveEnergySettings& _settings)
+{
+    auto result = _t_m.vertices().make_attribute<VertexRepulsiveEnergyRow>();
+    for (const auto t_v : _t_m.vertices()) {
+        result[t_v] = VertexRepulsiveEnergyRow(_vre.row(t_v.idx.value).transpose(), _settings);
+    }
+    return result;
+}
+
+}
+
+void Embedding::prepare_vertex_repulsive_energy() const
+{
+    if (!vertex_repulsive_energy.has_value()) {
+        vertex_repulsive_energy = vertex_repulsive_energy_attribute(target_mesh(), compute_vertex_repulsive_energy(*this, vre_settings), vre_settings);
+    }
+}
+
+void Embedding::set_vertex_repulsive_energy(const Eigen::MatrixXd& _vre)
+{
+    LE_ASSERT_EQ(_vre.rows(), target_mesh().vertices().size());
+    LE_ASSERT_EQ(_vre.cols(), layout_mesh().all_vertices().size());
+    vertex_repulsive_energy = vertex_repulsive_energy_attribute(target_mesh(), _vre, vre_settings);
+}
+
+void Embedding::set_vertex_repulsive_energy_settings(const VertexRepulsiveEnergySettings& _settings)
+{
+    vre_settings = _settings;
+    vertex_repulsive_energy.reset();
+}
+
+const VertexRepulsiveEnergySettings& Embedding::vertex_repulsive_energy_settings() const
+{
+    return vre_settings;
+}
+
 double Embedding::get_vertex_repulsive_energy(const VirtualVertex& _t_vv, const pm::vertex_handle& _l_v) const
 {
     LE_ASSERT(_l_v.mesh == &layout_mesh());
@@ -2,16 +2,19 @@
 
 #include <LayoutEmbedding/EmbeddingInput.hh>
 #include <LayoutEmbedding/LayoutGeneration.hh>
+#include <LayoutEmbedding/VertexRepulsiveEnergyRow.hh>
 #include <LayoutEmbedding/VirtualVertex.hh>
 #include <LayoutEmbedding/VirtualPath.hh>
 #include <polymesh/formats/obj.hh>
 
 #include <Eigen/Dense>
 
+#include <functional>
 #include <optional>
 
 namespace LayoutEmbedding {
 
+class SearchRegion;
 struct Snake;
 
 class Embedding
@@ -22,6 +25,14 @@ public:
     Embedding(const Embedding& _em);
     Embedding& operator=(const Embedding& _em);
 
+    /// Copies _em, but refers to the layout mesh of _input instead of the one of _em.
+    /// _input.l_m has to be a copy of _em.layout_mesh() with identical indices.
+    /// Embeddings with distinct inputs can be modified concurrently.
+    Embedding(const Embedding& _em, EmbeddingInput& _input);
+
+    /// Copies _em (which may refer to a different copy of the layout mesh, see above), but keeps referring to the own input.
+    void assign_keep_input(const Embedding& _em);
+
     /// If the layout halfedge _l_h has an embedding, returns the target halfedge at the start of the corresponding embedded path.
     /// Otherwise, returns an invalid halfedge.
     pm::halfedge_handle get_embedded_target_halfedge(const pm::halfedge_handle& _l_he) const;
@@ -48,10 +59,24 @@ public:
         VertexRepulsive,
     };
 
+    /// If _explored is given, it receives every virtual vertex that was expanded during the search.
+    /// If _is_in_region is given, the path only visits virtual vertices for which it returns true (apart from its endpoints).
     VirtualPath find_shortest_path(
         const pm::halfedge_handle& _t_h_sector_start, // Target halfedge, at the beginning of a sector
         const pm::halfedge_handle& _t_h_sector_end,   // Target halfedge, at the beginning of a sector
-        ShortestPathMetric _metric = ShortestPathMetric::Geodesic
+        ShortestPathMetric _metric = ShortestPathMetric::Geodesic,
+        std::vector<VirtualVertex>* _explored = nullptr,
+        const std::function<bool(const VirtualVertex&)>& _is_in_region = nullptr
+    ) const;
+    /// Restricted to _region (see SearchRegion.hh). If no path exists within the region,
+    /// the search is repeated in widened regions and finally (if allowed by _region) in the whole mesh.
+    /// If _num_widenings is given, it receives the number of widenings (max_widenings + 1 for the unrestricted search).
+    VirtualPath find_shortest_path(
+        const pm::halfedge_handle& _t_h_sector_start, // Target halfedge, at the beginning of a sector
+        const pm::halfedge_handle& _t_h_sector_end,   // Target halfedge, at the beginning of a sector
+        const SearchRegion& _region,
+        ShortestPathMetric _metric = ShortestPathMetric::Geodesic,
+        int* _num_widenings = nullptr
     ) const;
     VirtualPath find_shortest_path(
         const pm::halfedge_handle& _l_he, // Layout halfedge
@@ -97,10 +122,35 @@ public:
     const pm::halfedge_handle& matching_layout_halfedge(const pm::halfedge_handle& _t_h) const;
     pm::halfedge_handle& matching_layout_halfedge(const pm::halfedge_handle& _t_h);
 
+    /// Matches the layout vertex _l_v to the target vertex _t_v instead.
+    /// All layout edges incident to _l_v have to be unembedded and _t_v must not be blocked.
+    /// Discards the vertex repulsive energy, which depends on the matching.
+    void set_matching_target_vertex(const pm::vertex_handle& _l_v, const pm::vertex_handle& _t_v);
+
+    /// Removes the matching of the layout vertex _l_v, e.g. before _l_v is removed from the layout mesh.
+    /// All layout edges incident to _l_v have to be unembedded.
+    /// Discards the vertex repulsive energy, which depends on the matching.
+    void unmatch_layout_vertex(const pm::vertex_handle& _l_v);
+
     double get_vertex_repulsive_energy(const pm::vertex_handle& _t_v, const pm::vertex_handle& _l_v) const;
     double get_vertex_repulsive_energy(const VirtualVertex& _t_vv, const pm::vertex_handle& _l_v) const;
 
+    /// Computes the (otherwise lazily computed) vertex repulsive energy, if not available yet.
+    /// Copies made afterwards share the result instead of computing it again.
+    void prepare_vertex_repulsive_energy() const;
+
+    /// Uses a precomputed vertex repulsive energy (see compute_vertex_repulsive_energy),
+    /// e.g. one shared among embeddings with the same landmarks on the same target mesh.
+    /// Must be called before any paths are embedded (as these refine the target mesh).
+    void set_vertex_repulsive_energy(const Eigen::MatrixXd& _vre);
+
+    /// Controls how the vertex repulsive energy is computed and stored. Discards the current energy.
+    void set_vertex_repulsive_energy_settings(const VertexRepulsiveEnergySettings& _settings);
+    const VertexRepulsiveEnergySettings& vertex_repulsive_energy_settings() const;
+
 private:
+    void copy_from(const Embedding& _em, EmbeddingInput* _input);
+
     EmbeddingInput* input;
     pm::Mesh t_m; // Target mesh. Copy.
     pm::vertex_attribute<tg::pos3> t_pos; // Target mesh positions. Copy.
@@ -111,7 +161,8 @@ private:
 
     // Cache for the energy used for vertex repulsive path tracing [Praun2001].
     // Computed lazily when required. Access via get_vertex_repulsive_energy.
-    mutable std::optional<pm::vertex_attribute<Eigen::VectorXd>> vertex_repulsive_energy;
+    mutable std::optional<pm::vertex_attribute<VertexRepulsiveEnergyRow>> vertex_repulsive_energy;
+    VertexRepulsiveEnergySettings vre_settings;
 };
 
 }
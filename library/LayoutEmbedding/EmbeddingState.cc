@@ -4,6 +4,9 @@
 #include <LayoutEmbedding/VirtualPathConflictSentinel.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
 
+#include <algorithm>
+#include <functional>
+
 namespace LayoutEmbedding {
 
 EmbeddingState::EmbeddingState(const Embedding& _em, const BranchAndBoundSettings& _settings) :
@@ -77,6 +80,106 @@ void EmbeddingState::detect_candidate_path_conflicts()
     LE_ASSERT_EQ(c_em.layout_mesh().edges().size(), embedded_edges().size() + conflicting_edges().size() + non_conflicting_edges().size());
 }
 
+void EmbeddingState::compute_conflict_penalties(const ConflictPenalties* _inherited, const std::set<pm::edge_index>& _recomputed)
+{
+    const auto& l_m = em.layout_mesh();
+
+    // Layout vertices whose sectors changed due to the last insertion
+    std::set<pm::vertex_index> l_v_touched;
+    if (!insertion_sequence.empty()) {
+        const auto l_e_last = l_m.edges()[insertion_sequence.back()];
+        l_v_touched.insert(l_e_last.vertexA());
+        l_v_touched.insert(l_e_last.vertexB());
+    }
+    auto is_touched = [&](const pm::edge_index& _l_ei) {
+        const auto l_e = l_m.edges()[_l_ei];
+        return _recomputed.count(_l_ei) || l_v_touched.count(l_e.vertexA()) || l_v_touched.count(l_e.vertexB());
+    };
+
+    const HashValue embedded_hash = rerouted_lengths ? embedded_paths_hash() : 0;
+
+    conflict_penalties.clear();
+    for (const auto& conflict : conflicts) {
+        const auto& [l_ei_A, l_ei_B] = conflict;
+        if (_inherited && !is_touched(l_ei_A) && !is_touched(l_ei_B)) {
+            const auto it = _inherited->find(conflict);
+            if (it != _inherited->end()) {
+                // Both candidate paths and their endpoint sectors are unchanged. Insertions elsewhere may still
+                // change the cost of the reroute, which the heuristic ignores.
+                conflict_penalties[conflict] = it->second;
+                continue;
+            }
+        }
+        conflict_penalties[conflict] = conflict_penalty(l_ei_A, l_ei_B, embedded_hash);
+    }
+}
+
+double EmbeddingState::conflict_penalty(const pm::edge_index& _l_ei_A, const pm::edge_index& _l_ei_B) const
+{
+    return conflict_penalty(_l_ei_A, _l_ei_B, rerouted_lengths ? embedded_paths_hash() : 0);
+}
+
+double EmbeddingState::conflict_penalty(const pm::edge_index& _l_ei_A, const pm::edge_index& _l_ei_B, const HashValue& _embedded_hash) const
+{
+    const auto& l_m = em.layout_mesh();
+    const auto& path_A = candidate_paths[_l_ei_A];
+    const auto& path_B = candidate_paths[_l_ei_B];
+    if (path_A.empty() || path_B.empty()) {
+        return 0.0;
+    }
+    const double length_A = em.path_length(path_A);
+    const double length_B = em.path_length(path_B);
+
+    // Reroutes the second path around the first one without embedding it:
+    // The search on the state's embedding may not visit any interior virtual vertex of the first path.
+    // (Crossings within a single face are not detected, another reason why this is only an estimate.)
+    auto rerouted_length = [&](const pm::edge_index& _l_ei_first, const pm::edge_index& _l_ei_second) {
+        const auto& path_first = candidate_paths[_l_ei_first];
+        const auto& path_second = candidate_paths[_l_ei_second];
+
+        HashValue key = 0;
+        if (rerouted_lengths) {
+            // The same pair of candidate paths can be rerouted differently in states with other embedded paths.
+            key = hash_combine(_embedded_hash, LayoutEmbedding::hash(_l_ei_first.value));
+            key = hash_combine(key, LayoutEmbedding::hash(_l_ei_second.value));
+            for (const auto* path : { &path_first, &path_second }) {
+                for (const auto& vv : *path) {
+                    key = hash_combine(key, LayoutEmbedding::hash(em.element_pos(vv)));
+                }
+            }
+            const auto it = rerouted_lengths->find(key);
+            if (it != rerouted_lengths->end()) {
+                return it->second;
+            }
+        }
+
+        const std::set<VirtualVertex> obstacles(path_first.begin() + 1, path_first.end() - 1);
+        const auto l_he_second = l_m.edges()[_l_ei_second].halfedgeA();
+        const auto path = em.find_shortest_path(
+                    em.get_embeddable_sector(l_he_second),
+                    em.get_embeddable_sector(l_he_second.opposite()),
+                    Embedding::ShortestPathMetric::Geodesic,
+                    nullptr,
+                    [&](const VirtualVertex& _vv) { return obstacles.count(_vv) == 0; });
+        const double length = path.empty() ? std::numeric_limits<double>::infinity() : em.path_length(path);
+
+        if (rerouted_lengths) {
+            (*rerouted_lengths)[key] = length;
+        }
+        return length;
+    };
+
+    const double best_cost = std::min(
+                length_A + rerouted_length(_l_ei_A, _l_ei_B),
+                length_B + rerouted_length(_l_ei_B, _l_ei_A));
+
+    if (std::isinf(best_cost)) {
+        // Neither order admits a solution. Stay conservative.
+        return 0.0;
+    }
+    return std::max(0.0, best_cost - length_A - length_B);
+}
+
 std::vector<pm::edge_index> EmbeddingState::get_conflicting_candidates(const pm::edge_index& _l_ei)
 {
     std::vector<pm::edge_index> result;
@@ -107,6 +210,9 @@ bool EmbeddingState::valid() const
 double EmbeddingState::cost_lower_bound() const
 {
     if (settings->use_candidate_paths_for_lower_bounds) {
+        if (settings->use_conflict_penalty_heuristic) {
+            return embedded_cost() + unembedded_cost() + conflict_cost();
+        }
         return embedded_cost() + unembedded_cost();
     }
     else {
@@ -141,7 +247,100 @@ double EmbeddingState::unembedded_cost() const
     return result;
 }
 
-HashValue EmbeddingState::hash() const
+double EmbeddingState::conflict_cost() const
+{
+    // Penalties of vertex-disjoint pairs in the conflict graph can be summed, i.e. the maximum is a maximum-weight matching.
+    // Computed exactly per connected component of the conflict graph. Components with more than
+    // max_exact_matching_size vertices (rare, candidate paths conflict locally) are matched greedily
+    // by decreasing penalty instead, which is a 1/2-approximation.
+    constexpr int max_exact_matching_size = 16;
+
+    std::vector<std::pair<double, std::pair<pm::edge_index, pm::edge_index>>> weighted_conflicts;
+    UnionFind components(em.layout_mesh().all_edges().size());
+    for (const auto& [conflict, penalty] : conflict_penalties) {
+        if (penalty > 0.0 && conflicts.count(conflict)) {
+            weighted_conflicts.push_back({penalty, conflict});
+            components.merge(conflict.first.value, conflict.second.value);
+        }
+    }
+    std::sort(weighted_conflicts.begin(), weighted_conflicts.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.first > _rhs.first;
+    });
+
+    // Vertices of each component
+    std::map<int, std::vector<pm::edge_index>> component_vertices;
+    for (const auto& [penalty, conflict] : weighted_conflicts) {
+        for (const auto& l_ei : { conflict.first, conflict.second }) {
+            auto& vertices = component_vertices[components.representative(l_ei.value)];
+            if (std::find(vertices.begin(), vertices.end(), l_ei) == vertices.end()) {
+                vertices.push_back(l_ei);
+            }
+        }
+    }
+
+    double result = 0.0;
+    std::set<pm::edge_index> matched; // Greedily matched vertices
+    for (const auto& [penalty, conflict] : weighted_conflicts) {
+        const auto& [l_ei_A, l_ei_B] = conflict;
+        const auto& vertices = component_vertices[components.representative(l_ei_A.value)];
+        if ((int)vertices.size() <= max_exact_matching_size) {
+            continue;
+        }
+        if (matched.count(l_ei_A) || matched.count(l_ei_B)) {
+            continue;
+        }
+        matched.insert(l_ei_A);
+        matched.insert(l_ei_B);
+        result += penalty;
+    }
+
+    for (const auto& [representative, vertices] : component_vertices) {
+        const int n = vertices.size();
+        if (n > max_exact_matching_size) {
+            continue;
+        }
+        auto local_index = [&](const pm::edge_index& _l_ei) {
+            return int(std::find(vertices.begin(), vertices.end(), _l_ei) - vertices.begin());
+        };
+        std::vector<std::vector<double>> weights(n, std::vector<double>(n, 0.0));
+        for (const auto& [penalty, conflict] : weighted_conflicts) {
+            if (components.representative(conflict.first.value) == representative) {
+                const int i = local_index(conflict.first);
+                const int j = local_index(conflict.second);
+                weights[i][j] = weights[j][i] = std::max(weights[i][j], penalty);
+            }
+        }
+
+        // Dynamic programming over the sets of vertices that are not matched yet:
+        // The first of them is either left unmatched or matched to one of its neighbors.
+        std::vector<double> best_matching(std::size_t(1) << n, -1.0); // -1: not computed yet
+        std::function<double(unsigned)> solve = [&](unsigned _unmatched) {
+            if (_unmatched == 0) {
+                return 0.0;
+            }
+            if (best_matching[_unmatched] >= 0.0) {
+                return best_matching[_unmatched];
+            }
+            int i = 0;
+            while (!(_unmatched & (1u << i))) {
+                ++i;
+            }
+            const unsigned rest = _unmatched & ~(1u << i);
+            double best = solve(rest);
+            for (int j = i + 1; j < n; ++j) {
+                if ((rest & (1u << j)) && weights[i][j] > 0.0) {
+                    best = std::max(best, weights[i][j] + solve(rest & ~(1u << j)));
+                }
+            }
+            best_matching[_unmatched] = best;
+            return best;
+        };
+        result += solve((std::size_t(1) << n) - 1);
+    }
+    return result;
+}
+
+HashValue EmbeddingState::embedded_paths_hash() const
 {
     HashValue h = 0;
     for (const auto l_e : em.layout_mesh().edges()) {
@@ -153,6 +352,12 @@ HashValue EmbeddingState::hash() const
             }
         }
     }
+    return h;
+}
+
+HashValue EmbeddingState::hash() const
+{
+    HashValue h = embedded_paths_hash();
     if (!settings->use_state_hashing) {
         for (const auto& e_i : insertion_sequence) {
             h = hash_combine(h, LayoutEmbedding::hash(e_i.value));
@@ -5,6 +5,9 @@
 #include <LayoutEmbedding/Hash.hh>
 #include <LayoutEmbedding/InsertionSequence.hh>
 
+#include <map>
+#include <unordered_map>
+
 namespace LayoutEmbedding {
 
 /// EmbeddingState wraps a (copy of an) Embedding and provides additional functionality to
@@ -22,12 +25,29 @@ struct EmbeddingState
     void compute_all_candidate_paths();
     void detect_candidate_path_conflicts();
 
+    using ConflictPenalties = std::map<std::pair<pm::edge_index, pm::edge_index>, double>;
+
+    /// Lengths of rerouted candidate paths (see conflict_penalty), by the embedded paths of the state
+    /// (which determine the obstacles and sectors of the search) and the positions along both paths of the pair.
+    using ReroutedLengths = std::unordered_map<HashValue, double>;
+
+    /// Computes conflict_penalties for all pairs in conflicts (see BranchAndBoundSettings::use_conflict_penalty_heuristic).
+    /// Penalties from _inherited (i.e. the parent state) are reused if neither candidate path of a pair
+    /// was recomputed (see _recomputed) and neither edge shares a layout vertex with the last inserted edge.
+    void compute_conflict_penalties(const ConflictPenalties* _inherited = nullptr, const std::set<pm::edge_index>& _recomputed = {});
+
+    /// Estimated extra cost of resolving the conflict between the candidate paths of _l_ei_A and _l_ei_B:
+    /// The cheaper of both orders, keeping the first candidate path and rerouting the second one around it.
+    /// Not a lower bound, since a completion can also detour the first path.
+    double conflict_penalty(const pm::edge_index& _l_ei_A, const pm::edge_index& _l_ei_B) const;
+
     std::vector<pm::edge_index> get_conflicting_candidates(const pm::edge_index& _l_ei);
 
     bool valid() const;
     double cost_lower_bound() const;
     double embedded_cost() const;
     double unembedded_cost() const;
+    double conflict_cost() const;
 
     HashValue hash() const;
 
@@ -41,8 +61,19 @@ struct EmbeddingState
 
     pm::edge_attribute<VirtualPath> candidate_paths;
     std::set<std::pair<pm::edge_index, pm::edge_index>> conflicts;
+    ConflictPenalties conflict_penalties;
 
     const BranchAndBoundSettings* settings;
+
+    /// Optional. If set, conflict_penalty looks up (and adds) rerouted path lengths here.
+    ReroutedLengths* rerouted_lengths = nullptr;
+
+private:
+    /// _embedded_hash: embedded_paths_hash(), only used with rerouted_lengths.
+    double conflict_penalty(const pm::edge_index& _l_ei_A, const pm::edge_index& _l_ei_B, const HashValue& _embedded_hash) const;
+
+    /// Hash of the positions along all embedded paths (hash() without the insertion sequence).
+    HashValue embedded_paths_hash() const;
 };
 
 }
@@ -1,13 +1,22 @@
 #include "Greedy.hh"
 
 #include <LayoutEmbedding/IGLMesh.hh>
+#include <LayoutEmbedding/TentativePath.hh>
 #include <LayoutEmbedding/UnionFind.hh>
 #include <LayoutEmbedding/VirtualPort.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <memory>
 #include <set>
 #include <queue>
+#include <random>
+#include <tuple>
+#include <unordered_map>
 
 namespace LayoutEmbedding {
 
@@ -17,93 +26,164 @@ namespace {
 /// For each vertex around the face that is incident to _l_he on the left,
 /// a shortest path towards the given path is traced.
 /// If the path is hit from the right side (instead of the left), this is considered a potential swirl.
-/// Returns true if a potential swirl is detected, false otherwise.
-bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const VirtualPath& _path)
+///
+/// All per-vertex state lives in a workspace that is reused across queries.
+/// Entries are tagged with the query they belong to, so a query only touches the vertices it explores.
+class SwirlDetector
 {
-    const pm::Mesh& l_m = _em.layout_mesh();
-    const pm::Mesh& t_m = _em.target_mesh();
-    const pm::vertex_attribute<tg::pos3>& t_pos = _em.target_pos();
-
-    // Walk along the VertexEdgePath and mark the vertices directly left and right of it with a special attribute:
-    // The indicator attribute assigns each vertex a value in {-1, 0, 1},
-    // -1 meaning it is directly on the left of the arc,
-    // 1 meaning it is directly on the right of the arc,
-    // 0 otherwise.
-    pm::vertex_attribute<int> t_indicator(t_m);
-
-    LE_ASSERT(is_real_vertex(_path.front()));
-    LE_ASSERT(is_real_vertex(_path.back()));
-
-    for (int i = 0; i < _path.size(); ++i) {
-        const auto& vv = _path[i];
-
-        if (is_real_vertex(vv)) {
-            if (i > 0 && i < _path.size() - 1) {
-                const auto& el_prev = _path[i - 1];
-                const auto& el_next = _path[i + 1];
-                const auto& v = real_vertex(vv, t_m);
-
-                VirtualPort vh_start{v, el_prev};
-                VirtualPort vh_end{v, el_next};
-
-                auto vh_current = vh_start.rotated_cw();
-                while (vh_current != vh_end) {
-                    if (is_real_vertex(vh_current.to)) {
-                        const auto& v_to = real_vertex(vh_current.to);
-                        t_indicator[v_to] = -1; // "Left"
+public:
+    explicit SwirlDetector(const Embedding& _em) :
+        em(_em)
+    {
+    }
+
+    /// Returns true if a potential swirl is detected, false otherwise.
+    /// If _explored is given, it receives every target vertex whose neighborhood influenced the result.
+    bool detect(const pm::halfedge_handle& _l_he, const VirtualPath& _path, std::vector<pm::vertex_index>* _explored = nullptr)
+    {
+        const pm::Mesh& t_m = em.target_mesh();
+        const pm::vertex_attribute<tg::pos3>& t_pos = em.target_pos();
+
+        begin_query();
+
+        // Walk along the VertexEdgePath and mark the vertices directly left and right of it:
+        // -1 meaning it is directly on the left of the arc,
+        // 1 meaning it is directly on the right of the arc,
+        // 0 otherwise.
+        LE_ASSERT(is_real_vertex(_path.front()));
+        LE_ASSERT(is_real_vertex(_path.back()));
+
+        for (int i = 0; i < _path.size(); ++i) {
+            const auto& vv = _path[i];
+
+            if (is_real_vertex(vv)) {
+                if (i > 0 && i < _path.size() - 1) {
+                    const auto& el_prev = _path[i - 1];
+                    const auto& el_next = _path[i + 1];
+                    const auto& v = real_vertex(vv, t_m);
+                    if (_explored) {
+                        _explored->push_back(v.idx);
+                    }
+
+                    VirtualPort vh_start{v, el_prev};
+                    VirtualPort vh_end{v, el_next};
+
+                    auto vh_current = vh_start.rotated_cw();
+                    while (vh_current != vh_end) {
+                        if (is_real_vertex(vh_current.to)) {
+                            set_indicator(real_vertex(vh_current.to), -1); // "Left"
+                        }
+                        vh_current = vh_current.rotated_cw();
+                    }
+
+                    while (vh_current != vh_start) {
+                        if (is_real_vertex(vh_current.to)) {
+                            set_indicator(real_vertex(vh_current.to), 1); // "Right"
+                        }
+                        vh_current = vh_current.rotated_cw();
+                    }
+                }
+            }
+            else if (is_real_edge(vv)) {
+                LE_ASSERT_G(i, 0);
+                LE_ASSERT_L(i, _path.size() - 1);
+
+                const auto& e = real_edge(vv, t_m);
+                auto he = pm::halfedge_handle::invalid;
+
+                const auto& vv_next = _path[i + 1];
+                if (is_real_vertex(vv_next)) {
+                    const auto& v_next = real_vertex(vv_next);
+                    if (e.halfedgeA().next().vertex_to() == v_next) {
+                        he = e.halfedgeA();
+                    }
+                    else if (e.halfedgeB().next().vertex_to() == v_next) {
+                        he = e.halfedgeB();
                     }
-                    vh_current = vh_current.rotated_cw();
                 }
+                else if (is_real_edge(vv_next)) {
+                    const auto& e_next = real_edge(vv_next, t_m);
 
-                while (vh_current != vh_start) {
-                    if (is_real_vertex(vh_current.to)) {
-                        const auto& v_to = real_vertex(vh_current.to);
-                        t_indicator[v_to] = 1; // "Right"
+                    if ((e.halfedgeA().face() == e_next.halfedgeA().face()) || (e.halfedgeA().face() == e_next.halfedgeB().face())) {
+                        he = e.halfedgeA();
+                    }
+                    else if ((e.halfedgeB().face() == e_next.halfedgeA().face()) || (e.halfedgeB().face() == e_next.halfedgeB().face())) {
+                        he = e.halfedgeB();
                     }
-                    vh_current = vh_current.rotated_cw();
+                }
+
+                LE_ASSERT(he.is_valid());
+                set_indicator(he.vertex_from().idx, -1); // "Left"
+                set_indicator(he.vertex_to().idx, 1); // "Right"
+                if (_explored) {
+                    _explored->push_back(he.vertex_from().idx);
+                    _explored->push_back(he.vertex_to().idx);
                 }
             }
         }
-        else if (is_real_edge(vv)) {
-            LE_ASSERT_G(i, 0);
-            LE_ASSERT_L(i, _path.size() - 1);
 
-            const auto& e = real_edge(vv, t_m);
-            auto he = pm::halfedge_handle::invalid;
+        // Start a shortest-path search from the seed vertices and see whether it first meets a vertex marked "Left" (good) or "Right" (bad)
+        const auto& l_f = _l_he.face();
+        for (const auto l_v : l_f.vertices()) {
+            if ((l_v == _l_he.vertex_from()) || (l_v == _l_he.vertex_to())) {
+                continue;
+            }
+            const auto t_v = em.matching_target_vertex(l_v);
+            set_distance(t_v.idx, 0.0);
+            push({0.0, t_v.idx});
+        }
 
-            const auto& vv_next = _path[i + 1];
-            if (is_real_vertex(vv_next)) {
-                const auto& v_next = real_vertex(vv_next);
-                if (e.halfedgeA().next().vertex_to() == v_next) {
-                    he = e.halfedgeA();
-                }
-                else if (e.halfedgeB().next().vertex_to() == v_next) {
-                    he = e.halfedgeB();
-                }
+        while (!heap.empty()) {
+            const auto c = pop();
+            if (c.distance > distance(c.v)) {
+                continue; // Outdated entry
+            }
+            if (_explored) {
+                _explored->push_back(c.v);
             }
-            else if (is_real_edge(vv_next)) {
-                const auto& e_next = real_edge(vv_next, t_m);
 
-                if ((e.halfedgeA().face() == e_next.halfedgeA().face()) || (e.halfedgeA().face() == e_next.halfedgeB().face())) {
-                    he = e.halfedgeA();
-                }
-                else if ((e.halfedgeB().face() == e_next.halfedgeA().face()) || (e.halfedgeB().face() == e_next.halfedgeB().face())) {
-                    he = e.halfedgeB();
-                }
+            const int ind = indicator(c.v);
+            if (ind == -1) {
+                // We arrived on the correct (left) side of the path. Probably no spiral.
+                return false;
+            }
+            else if (ind == 1) {
+                // We arrived on the wrong (right) side of the path. Spiral detected.
+                return true;
             }
 
-            LE_ASSERT(he.is_valid());
-            t_indicator[he.vertex_from()] = -1; // "Left"
-            t_indicator[he.vertex_to()] = 1; // "Right"
+            const auto v = t_m.vertices()[c.v];
+            for (const auto he : v.outgoing_halfedges()) {
+                const auto& v_to = he.vertex_to();
+                const double new_distance = c.distance + tg::distance(t_pos[v], t_pos[v_to]);
+                if (new_distance < distance(v_to.idx)) {
+                    set_distance(v_to.idx, new_distance);
+                    push({new_distance, v_to.idx});
+                }
+            }
         }
+        // This will likely be never reached
+        return false;
     }
 
-    // Start a shortest-path search from the seed vertices and see whether it first meets a vertex marked "Left" (good) or "Right" (bad)
+    bool detect_bidirectional(const pm::halfedge_handle& _l_he, const VirtualPath& _path, std::vector<pm::vertex_index>* _explored = nullptr)
+    {
+        if (detect(_l_he, _path, _explored)) {
+            return true;
+        }
+        else {
+            const auto l_he_opp = _l_he.opposite();
+            auto path_opp = _path;
+            std::reverse(path_opp.begin(), path_opp.end());
+            return detect(l_he_opp, path_opp, _explored);
+        }
+    }
 
+private:
     struct Candidate
     {
         double distance;
-        pm::vertex_handle v;
+        pm::vertex_index v;
 
         bool operator<(const Candidate& _rhs) const
         {
@@ -111,58 +191,65 @@ bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const Vir
         }
     };
 
-    pm::vertex_attribute<double> distance(t_m, std::numeric_limits<double>::infinity());
-    std::priority_queue<Candidate> q;
-    std::vector<pm::vertex_handle> t_seed_vertices;
-    const auto& l_f = _l_he.face();
-    for (const auto l_v : l_f.vertices()) {
-        if ((l_v == _l_he.vertex_from()) || (l_v == _l_he.vertex_to())) {
-            continue;
+    void begin_query()
+    {
+        // The target mesh grows while paths are embedded
+        const int n = em.target_mesh().all_vertices().size();
+        if (query_of_indicator.size() < (std::size_t)n) {
+            query_of_indicator.resize(n, -1);
+            indicator_values.resize(n);
+            query_of_distance.resize(n, -1);
+            distance_values.resize(n);
         }
-        const auto t_v = _em.matching_target_vertex(l_v);
-        t_seed_vertices.push_back(t_v);
-        distance[t_v] = 0.0;
-        q.push({0.0, t_v});
+        ++query;
+        heap.clear();
     }
 
-    while (!q.empty()) {
-        const auto c = q.top();
-        q.pop();
+    int indicator(const pm::vertex_index& _v) const
+    {
+        return (query_of_indicator[_v.value] == query) ? indicator_values[_v.value] : 0;
+    }
 
-        if (t_indicator[c.v] == -1) {
-            // We arrived on the correct (left) side of the path. Probably no spiral.
-            return false;
-        }
-        else if (t_indicator[c.v] == 1) {
-            // We arrived on the wrong (right) side of the path. Spiral detected.
-            return true;
-        }
+    void set_indicator(const pm::vertex_index& _v, const int _value)
+    {
+        query_of_indicator[_v.value] = query;
+        indicator_values[_v.value] = _value;
+    }
 
-        for (const auto he : c.v.outgoing_halfedges()) {
-            const auto& v_to = he.vertex_to();
-            const double new_distance = distance[c.v] + tg::distance(t_pos[c.v], t_pos[v_to]);
-            if (new_distance < distance[v_to]) {
-                distance[v_to] = new_distance;
-                q.push({new_distance, v_to});
-            }
-        }
+    double distance(const pm::vertex_index& _v) const
+    {
+        return (query_of_distance[_v.value] == query) ? distance_values[_v.value] : std::numeric_limits<double>::infinity();
     }
-    // This will likely be never reached
-    return false;
-}
 
-bool swirl_detection_bidirectional(Embedding& _em, const pm::halfedge_handle& _l_he, const VirtualPath& _path)
-{
-    if (swirl_detection(_em, _l_he, _path)) {
-        return true;
+    void set_distance(const pm::vertex_index& _v, const double _value)
+    {
+        query_of_distance[_v.value] = query;
+        distance_values[_v.value] = _value;
     }
-    else {
-        const auto l_he_opp = _l_he.opposite();
-        auto path_opp = _path;
-        std::reverse(path_opp.begin(), path_opp.end());
-        return swirl_detection(_em, l_he_opp, path_opp);
+
+    void push(const Candidate& _c)
+    {
+        heap.push_back(_c);
+        std::push_heap(heap.begin(), heap.end());
     }
-}
+
+    Candidate pop()
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        const auto c = heap.back();
+        heap.pop_back();
+        return c;
+    }
+
+    const Embedding& em;
+
+    int query = 0;
+    std::vector<int> query_of_indicator;
+    std::vector<int> indicator_values;
+    std::vector<int> query_of_distance;
+    std::vector<double> distance_values;
+    std::vector<Candidate> heap; // Kept to reuse its capacity
+};
 
 /// [Kraevoy2003] / [Kraevoy2004] blocking condition.
 /// _l_h_seed is already (temporarily) embedded.
@@ -251,11 +338,282 @@ bool is_blocking(const Embedding& _em, const pm::edge_handle& _l_e, const Virtua
     return is_blocking(em_copy, _l_e.halfedgeA()) || is_blocking(em_copy, _l_e.halfedgeB());
 }
 
+/// Same as above, but only visits the two regions adjacent to the tentatively embedded path
+/// instead of copying the Embedding and splitting its target mesh.
+bool is_blocking_tentative(const Embedding& _em, const pm::edge_handle& _l_e, const VirtualPath& _path)
+{
+    LE_ASSERT(!_em.is_embedded(_l_e));
+
+    const TentativePath tentative(_em, _l_e, _path);
+    if (!tentative.is_valid()) {
+        return is_blocking(_em, _l_e, _path);
+    }
+
+    for (const auto l_h_seed : {_l_e.halfedgeA(), _l_e.halfedgeB()}) {
+        // Collect vertices in layout
+        std::set<pm::vertex_index> l_vertices;
+        tentative.flood_fill_layout(l_h_seed, [&](const pm::face_handle& _l_f) {
+            for (const auto l_v : _l_f.vertices()) {
+                l_vertices.insert(l_v.idx);
+            }
+            return true;
+        });
+
+        // Collect vertices in target mesh. Early-out on the first one that is missing in the layout.
+        std::set<pm::vertex_index> t_vertices;
+        const bool subset = tentative.flood_fill_target(l_h_seed, [&](const pm::vertex_handle& _t_v) {
+            const auto l_v = _em.matching_layout_vertex(_t_v);
+            if (l_v.is_valid()) {
+                if (!l_vertices.count(l_v.idx)) {
+                    return false;
+                }
+                t_vertices.insert(l_v.idx);
+            }
+            return true;
+        });
+
+        if (!subset || l_vertices.size() != t_vertices.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Shortest path candidates for the unembedded layout edges, ranked by (priority, cost, edge index).
+/// Each candidate remembers the target elements expanded by its search.
+/// Embedding a path only modifies the target faces it touches (and the sectors at its endpoints),
+/// so only candidates whose search expanded an element of those faces need to be re-traced.
+/// The search is deterministic, so all other candidates equal the result of a fresh search.
+/// Swirl test results are cached the same way, keyed by the target vertices the test explored.
+class CandidatePaths
+{
+public:
+    using ElementKey = std::int64_t;
+    using Ranking = std::set<std::tuple<int, double, int>>;
+
+    struct Entry
+    {
+        VirtualPath path;
+        double cost = std::numeric_limits<double>::infinity();
+        int priority = 0;
+        bool up_to_date = false;
+        std::vector<ElementKey> region;
+
+        std::optional<bool> swirl;
+        std::vector<ElementKey> swirl_region;
+    };
+
+    CandidatePaths(const Embedding& _em, const Embedding::ShortestPathMetric _metric, const std::function<int(const pm::edge_handle&)>& _priority) :
+        em(_em),
+        metric(_metric),
+        priority(_priority),
+        entries(_em.layout_mesh().all_edges().size())
+    {
+    }
+
+    /// Traces the candidate path of _l_e unless it is up to date.
+    const Entry& get(const pm::edge_handle& _l_e)
+    {
+        auto& entry = entries[_l_e.idx.value];
+        if (!entry.up_to_date) {
+            trace(_l_e);
+        }
+        return entry;
+    }
+
+    /// Swirl test of the (up-to-date) candidate path of _l_e, evaluated only if not cached.
+    bool is_swirl(const pm::edge_handle& _l_e, SwirlDetector& _detector)
+    {
+        const int l_ei = _l_e.idx.value;
+        auto& entry = entries[l_ei];
+        LE_ASSERT(entry.up_to_date);
+        if (!entry.swirl) {
+            std::vector<pm::vertex_index> explored;
+            entry.swirl = _detector.detect_bidirectional(_l_e.halfedgeA(), entry.path, &explored);
+
+            entry.swirl_region.clear();
+            for (const auto& t_v : explored) {
+                entry.swirl_region.push_back(key(VirtualVertex(t_v)));
+            }
+            std::sort(entry.swirl_region.begin(), entry.swirl_region.end());
+            entry.swirl_region.erase(std::unique(entry.swirl_region.begin(), entry.swirl_region.end()), entry.swirl_region.end());
+            for (const auto& k : entry.swirl_region) {
+                swirl_owners[k].push_back(l_ei);
+            }
+        }
+        return *entry.swirl;
+    }
+
+    /// All up-to-date candidates
+    const Ranking& ranking() const
+    {
+        return rank;
+    }
+
+    /// Must be called before _path is embedded as _l_e.
+    void invalidate(const pm::edge_handle& _l_e, const VirtualPath& _path)
+    {
+        discard(_l_e.idx.value);
+
+        // The sectors at both endpoints change
+        for (const auto l_v : { _l_e.vertexA(), _l_e.vertexB() }) {
+            for (const auto l_he : l_v.outgoing_halfedges()) {
+                discard(l_he.edge().idx.value);
+            }
+        }
+
+        // Faces touched by the path will be split (or get blocked edges).
+        std::vector<pm::face_handle> t_faces;
+        for (const auto& vv : _path) {
+            if (is_real_vertex(vv)) {
+                for (const auto t_f : real_vertex(vv, em.target_mesh()).faces()) {
+                    if (t_f.is_valid()) {
+                        t_faces.push_back(t_f);
+                    }
+                }
+            }
+            else {
+                const auto t_e = real_edge(vv, em.target_mesh());
+                for (const auto t_f : { t_e.halfedgeA().face(), t_e.halfedgeB().face() }) {
+                    if (t_f.is_valid()) {
+                        t_faces.push_back(t_f);
+                    }
+                }
+            }
+        }
+        for (const auto t_f : t_faces) {
+            for (const auto t_v : t_f.vertices()) {
+                discard_region(key(VirtualVertex(t_v)));
+                discard_swirl_region(key(VirtualVertex(t_v)));
+            }
+            for (const auto t_e : t_f.edges()) {
+                discard_region(key(VirtualVertex(t_e)));
+            }
+        }
+    }
+
+private:
+    static ElementKey key(const VirtualVertex& _vv)
+    {
+        if (is_real_vertex(_vv)) {
+            return 2 * (ElementKey)real_vertex(_vv).value;
+        }
+        else {
+            return 2 * (ElementKey)real_edge(_vv).value + 1;
+        }
+    }
+
+    void trace(const pm::edge_handle& _l_e)
+    {
+        const int l_ei = _l_e.idx.value;
+        auto& entry = entries[l_ei];
+        LE_ASSERT(!entry.up_to_date);
+
+        const auto l_he = _l_e.halfedgeA();
+        const auto t_he_sector_start = em.get_embeddable_sector(l_he);
+        const auto t_he_sector_end = em.get_embeddable_sector(l_he.opposite());
+
+        std::vector<VirtualVertex> explored;
+        entry.path = em.find_shortest_path(t_he_sector_start, t_he_sector_end, metric, &explored);
+        entry.cost = em.path_length(entry.path);
+        entry.priority = priority(_l_e);
+        entry.up_to_date = true;
+
+        // The neighborhood of the end vertex defines the legal final steps, even if it was never expanded.
+        explored.push_back(VirtualVertex(t_he_sector_end.vertex_from()));
+
+        entry.region.clear();
+        for (const auto& vv : explored) {
+            entry.region.push_back(key(vv));
+        }
+        std::sort(entry.region.begin(), entry.region.end());
+        entry.region.erase(std::unique(entry.region.begin(), entry.region.end()), entry.region.end());
+        for (const auto& k : entry.region) {
+            owners[k].push_back(l_ei);
+        }
+
+        rank.insert({entry.priority, entry.cost, l_ei});
+    }
+
+    void discard(const int _l_ei)
+    {
+        auto& entry = entries[_l_ei];
+        if (!entry.up_to_date) {
+            return;
+        }
+        rank.erase({entry.priority, entry.cost, _l_ei});
+        remove_owner(owners, entry.region, _l_ei);
+        entry.region.clear();
+        entry.up_to_date = false;
+        discard_swirl(_l_ei);
+    }
+
+    void discard_swirl(const int _l_ei)
+    {
+        auto& entry = entries[_l_ei];
+        if (!entry.swirl) {
+            return;
+        }
+        remove_owner(swirl_owners, entry.swirl_region, _l_ei);
+        entry.swirl_region.clear();
+        entry.swirl.reset();
+    }
+
+    static void remove_owner(std::unordered_map<ElementKey, std::vector<int>>& _owners, const std::vector<ElementKey>& _region, const int _l_ei)
+    {
+        for (const auto& k : _region) {
+            auto it = _owners.find(k);
+            if (it == _owners.end()) {
+                continue;
+            }
+            auto& l_eis = it->second;
+            l_eis.erase(std::remove(l_eis.begin(), l_eis.end(), _l_ei), l_eis.end());
+            if (l_eis.empty()) {
+                _owners.erase(it);
+            }
+        }
+    }
+
+    void discard_region(const ElementKey& _key)
+    {
+        const auto it = owners.find(_key);
+        if (it == owners.end()) {
+            return;
+        }
+        const std::vector<int> l_eis = it->second; // Copy, discard() modifies the owner lists
+        for (const int l_ei : l_eis) {
+            discard(l_ei);
+        }
+    }
+
+    void discard_swirl_region(const ElementKey& _key)
+    {
+        const auto it = swirl_owners.find(_key);
+        if (it == swirl_owners.end()) {
+            return;
+        }
+        const std::vector<int> l_eis = it->second; // Copy, discard_swirl() modifies the owner lists
+        for (const int l_ei : l_eis) {
+            discard_swirl(l_ei);
+        }
+    }
+
+    const Embedding& em;
+    const Embedding::ShortestPathMetric metric;
+    const std::function<int(const pm::edge_handle&)> priority;
+
+    std::vector<Entry> entries;
+    std::unordered_map<ElementKey, std::vector<int>> owners; // Target element -> candidates whose search expanded it
+    std::unordered_map<ElementKey, std::vector<int>> swirl_owners; // Target vertex -> candidates whose swirl test explored it
+    Ranking rank;
+};
+
 }
 
 GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const std::string& _name)
 {
     GreedyResult result(_name, _settings);
+    ProgressReporter progress(&_settings.progress, _name);
 
     // If vertex-repulsive tracing is enabled, copy input embedding.
     // Used to re-trace paths as shortest paths.
@@ -273,8 +631,13 @@ GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const
             double total_distance = 0.0;
             int valence = 0;
             for (const auto l_he : l_v.outgoing_halfedges()) {
-                const auto path = _em.find_shortest_path(l_he);
-                total_distance += _em.path_length(path);
+                if (_em.is_embedded(l_he)) {
+                    total_distance += _em.embedded_path_length(l_he);
+                }
+                else {
+                    const auto path = _em.find_shortest_path(l_he);
+                    total_distance += _em.path_length(path);
+                }
                 ++valence;
             }
             l_avg_neighbor_distance[l_v] = total_distance / valence;
@@ -306,83 +669,194 @@ GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const
     // If edges fail the "Swirl Test", their score will receive a penalty so they are processed later.
     pm::edge_attribute<bool> l_penalty(l_m);
 
+    // Paths that are already embedded (e.g. when re-embedding after a local edit) are kept.
+    // Indices are not necessarily compact, as the layout mesh may have been edited.
     pm::edge_attribute<bool> l_is_embedded(l_m);
-    const int l_num_vertices = l_m.vertices().size();
     const int l_num_edges = l_m.edges().size();
     int l_num_embedded_edges = 0;
 
-    UnionFind l_v_components(l_m.vertices().size());
+    UnionFind l_v_components(l_m.all_vertices().size());
+    int l_num_components = l_m.vertices().size();
+
+    for (const auto l_e : l_m.edges()) {
+        if (_em.is_embedded(l_e)) {
+            l_is_embedded[l_e] = true;
+            ++l_num_embedded_edges;
+            if (!l_v_components.equivalent(l_e.vertexA().idx.value, l_e.vertexB().idx.value)) {
+                l_v_components.merge(l_e.vertexA().idx.value, l_e.vertexB().idx.value);
+                --l_num_components;
+            }
+        }
+    }
+
+    auto metric = Embedding::ShortestPathMetric::Geodesic;
+    if (_settings.use_vertex_repulsive_tracing) {
+        metric = Embedding::ShortestPathMetric::VertexRepulsive;
+    }
+
+    CandidatePaths candidates(_em, metric, [&] (const pm::edge_handle& _l_e) {
+        return 1 - incident_to_extremal_vertex(_l_e);
+    });
+    SwirlDetector swirl_detector(_em);
+
+    LE_ASSERT_GEQ(_settings.restricted_candidate_list_size, 1);
+    const int rcl_size = _settings.restricted_candidate_list_size;
+    std::mt19937 rng(_settings.seed);
 
     while (l_num_embedded_edges < l_num_edges) {
+        if (progress.cancelled()) {
+            result.cancelled = true;
+            return result;
+        }
+
+        if (progress.due()) {
+            ProgressSnapshot snapshot;
+            snapshot.iteration = l_num_embedded_edges;
+            snapshot.num_done = l_num_embedded_edges;
+            snapshot.num_total = l_num_edges;
+            progress.report(snapshot);
+        }
+
         VirtualPath best_path;
         double best_path_cost = std::numeric_limits<double>::infinity();
         pm::edge_handle best_l_e = pm::edge_handle::invalid;
 
-        const bool is_spanning_tree = (l_num_embedded_edges >= l_num_vertices - 1);
+        const bool is_spanning_tree = (l_num_components == 1);
 
-        for (const auto l_e : l_m.edges()) {
-            if (l_is_embedded[l_e]) {
-                continue;
+        auto is_eligible = [&] (const pm::edge_handle& _l_e) {
+            if (l_is_embedded[_l_e]) {
+                return false;
             }
-
-            int l_vi_a = l_e.vertexA().idx.value;
-            int l_vi_b = l_e.vertexB().idx.value;
-
             if (!_settings.use_blocking_condition) {
                 if (!is_spanning_tree) {
-                    if (l_v_components.equivalent(l_vi_a, l_vi_b)) {
-                        continue;
+                    if (l_v_components.equivalent(_l_e.vertexA().idx.value, _l_e.vertexB().idx.value)) {
+                        return false;
                     }
                 }
             }
+            return true;
+        };
 
-            auto metric = Embedding::ShortestPathMetric::Geodesic;
-            if (_settings.use_vertex_repulsive_tracing) {
-                metric = Embedding::ShortestPathMetric::VertexRepulsive;
-            }
-
-            VirtualPath path = _em.find_shortest_path(l_e.halfedgeA(), metric);
-            double path_cost = _em.path_length(path);
-
-            // If we use the blocking condition, we have to discard the path if
-            // the vertices enclosed in new patches differ between the layout and the embedding.
+        // If we use the blocking condition, we have to discard the path if
+        // the vertices enclosed in new patches differ between the layout and the embedding.
+        auto is_blocked_candidate = [&] (const pm::edge_handle& _l_e, const VirtualPath& _path) {
             if (_settings.use_blocking_condition) {
-                if (l_v_components.equivalent(l_vi_a, l_vi_b)) {
-                    if (is_blocking(_em, l_e, path)) {
-                        continue;
-                    }
+                if (l_v_components.equivalent(_l_e.vertexA().idx.value, _l_e.vertexB().idx.value)) {
+                    return is_blocking_tentative(_em, _l_e, _path);
                 }
             }
+            return false;
+        };
 
+        if (_settings.insertion_order == GreedySettings::InsertionOrder::Arbitrary) {
             // If we use an arbitrary insertion order, we can early-out after the first path is found
-            if (_settings.insertion_order == GreedySettings::InsertionOrder::Arbitrary) {
-                best_path_cost = path_cost;
-                best_path = std::move(path);
+            for (const auto l_e : l_m.edges()) {
+                if (!is_eligible(l_e)) {
+                    continue;
+                }
+                const auto& candidate = candidates.get(l_e);
+                if (is_blocked_candidate(l_e, candidate.path)) {
+                    continue;
+                }
+                best_path_cost = candidate.cost;
+                best_path = candidate.path;
                 best_l_e = l_e;
                 break;
             }
+        }
+        else {
+            // Bring all eligible candidates up to date
+            for (const auto l_e : l_m.edges()) {
+                if (is_eligible(l_e)) {
+                    candidates.get(l_e);
+                }
+            }
+
+            // Restricted candidate list: The rcl_size best (priority, cost, edge index) tuples, in ascending order.
+            std::vector<std::tuple<int, double, int>> rcl;
 
-            if (_settings.use_swirl_detection) {
-                // Only do the swirl test if the current path is already a contender.
-                if (path_cost < best_path_cost) {
-                    if (swirl_detection_bidirectional(_em, l_e.halfedgeA(), path)) {
-                        path_cost *= _settings.swirl_penalty_factor;
+            if (!_settings.use_swirl_detection) {
+                // The best candidates are the first eligible, non-blocking ones in the ranking.
+                for (const auto& [priority, cost, l_ei] : candidates.ranking()) {
+                    const auto l_e = l_m.edges()[pm::edge_index(l_ei)];
+                    if (!is_eligible(l_e)) {
+                        continue;
+                    }
+                    const auto& candidate = candidates.get(l_e);
+                    if (is_blocked_candidate(l_e, candidate.path)) {
+                        continue;
+                    }
+                    rcl.push_back({priority, cost, l_ei});
+                    if ((int)rcl.size() >= rcl_size) {
+                        break;
                     }
                 }
             }
+            else {
+                // Swirl penalties depend on the running best costs, so we scan in index order.
+                for (const auto l_e : l_m.edges()) {
+                    if (!is_eligible(l_e)) {
+                        continue;
+                    }
+                    const auto& candidate = candidates.get(l_e);
+                    double path_cost = candidate.cost;
+
+                    // Penalties only increase the cost. Candidates that cannot enter the list are skipped early.
+                    int worst_extremal_priority = 1;
+                    double worst_path_cost = std::numeric_limits<double>::infinity();
+                    if ((int)rcl.size() >= rcl_size) {
+                        worst_extremal_priority = std::get<0>(rcl.back());
+                        worst_path_cost = std::get<1>(rcl.back());
+                    }
+                    if (!(std::tie(candidate.priority, path_cost) < std::tie(worst_extremal_priority, worst_path_cost))) {
+                        continue;
+                    }
 
-            const int extremal_priority = 1 - incident_to_extremal_vertex(l_e);
-            const int best_extremal_priority = 1 - incident_to_extremal_vertex(best_l_e);
-            if (std::tie(extremal_priority, path_cost) < std::tie(best_extremal_priority, best_path_cost)) {
-                best_path_cost = path_cost;
-                best_path = std::move(path);
-                best_l_e = l_e;
+                    if (is_blocked_candidate(l_e, candidate.path)) {
+                        continue;
+                    }
+
+                    // Only do the swirl test if the current path is already a contender.
+                    if (path_cost < worst_path_cost) {
+                        if (candidates.is_swirl(l_e, swirl_detector)) {
+                            path_cost *= _settings.swirl_penalty_factor;
+                        }
+                    }
+
+                    if (std::tie(candidate.priority, path_cost) < std::tie(worst_extremal_priority, worst_path_cost)) {
+                        const std::tuple<int, double, int> entry{candidate.priority, path_cost, l_e.idx.value};
+                        rcl.insert(std::upper_bound(rcl.begin(), rcl.end(), entry), entry);
+                        if ((int)rcl.size() > rcl_size) {
+                            rcl.pop_back();
+                        }
+                    }
+                }
+            }
+
+            if (!rcl.empty()) {
+                int choice = 0;
+                if (rcl.size() > 1) {
+                    choice = std::uniform_int_distribution<int>(0, rcl.size() - 1)(rng);
+                }
+                best_l_e = l_m.edges()[pm::edge_index(std::get<2>(rcl[choice]))];
+                best_path_cost = std::get<1>(rcl[choice]);
+                best_path = candidates.get(best_l_e).path;
             }
         }
 
+        if (!best_l_e.is_valid()) {
+            // None of the remaining edges can be embedded
+            return result;
+        }
+
+        candidates.invalidate(best_l_e, best_path);
+
         result.insertion_sequence.push_back(best_l_e);
         _em.embed_path(best_l_e.halfedgeA(), best_path);
-        l_v_components.merge(best_l_e.vertexA().idx.value, best_l_e.vertexB().idx.value);
+        if (!l_v_components.equivalent(best_l_e.vertexA().idx.value, best_l_e.vertexB().idx.value)) {
+            l_v_components.merge(best_l_e.vertexA().idx.value, best_l_e.vertexB().idx.value);
+            --l_num_components;
+        }
         l_is_embedded[best_l_e] = true;
         ++l_num_embedded_edges;
     }
@@ -402,6 +876,15 @@ GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const
     LE_ASSERT(_em.is_complete());
     result.cost = _em.total_embedded_path_length();
 
+    {
+        ProgressSnapshot snapshot;
+        snapshot.iteration = l_num_edges;
+        snapshot.num_done = l_num_edges;
+        snapshot.num_total = l_num_edges;
+        snapshot.upper_bound = result.cost;
+        progress.report(snapshot, true);
+    }
+
     return result;
 }
 
@@ -438,47 +921,141 @@ GreedyResult embed_schreiner(Embedding& _em, const GreedySettings& _settings)
     return embed_greedy(_em, settings, "schreiner");
 }
 
-std::vector<GreedyResult> embed_greedy(Embedding& _em, const std::vector<GreedySettings>& _all_settings)
+namespace {
+
+/// Runs all variants in parallel. Once _time_limit (seconds) has passed, running variants are cancelled
+/// and variants that have not started yet are skipped.
+std::vector<GreedyResult> embed_greedy_parallel(Embedding& _em, const std::vector<GreedySettings>& _all_settings, const double _time_limit)
 {
+    using Clock = std::chrono::steady_clock;
+    const auto start_time = Clock::now();
+
     const int n = _all_settings.size();
-    std::vector<Embedding> all_embeddings(n, _em); // n copies
+
+    // Compute the vertex repulsive energy once. All copies below inherit it.
+    for (const auto& settings : _all_settings) {
+        if (settings.use_vertex_repulsive_tracing) {
+            _em.prepare_vertex_repulsive_energy();
+            break;
+        }
+    }
+
+    // Each variant works on its own copy of the layout mesh,
+    // since creating attributes (e.g. in find_shortest_path) is not thread-safe.
+    std::vector<EmbeddingInput> all_inputs(n);
+    for (auto& input : all_inputs) {
+        input.l_m.copy_from(_em.layout_mesh());
+        input.l_pos = input.l_m.vertices().make_attribute<tg::pos3>();
+        input.l_pos.copy_from(_em.layout_pos());
+    }
+
+    // Per variant, the time limit is enforced via a token that also forwards cancellation by the caller.
+    std::vector<CancellationToken> all_tokens(n);
+    for (int i = 0; i < n; ++i) {
+        all_tokens[i].set_parent(_all_settings[i].progress.cancellation_token);
+        if (std::isfinite(_time_limit)) {
+            all_tokens[i].set_deadline(start_time + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_time_limit)));
+        }
+    }
+
+    std::vector<std::unique_ptr<Embedding>> all_embeddings(n);
     std::vector<GreedyResult> all_results(n);
+    std::vector<std::exception_ptr> all_exceptions(n);
 
-    //#pragma omp parallel for
-    for (std::size_t i = 0; i < n; ++i) {
-        const auto& settings = _all_settings[i];
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < n; ++i) {
+        try {
+            auto settings = _all_settings[i];
+            auto& result = all_results[i];
 
-        auto& em = all_embeddings[i];
-        auto& result = all_results[i];
+            if (all_tokens[i].cancelled()) {
+                result = GreedyResult("greedy", settings);
+                result.cancelled = true;
+                continue;
+            }
 
-        em = _em; // copy
-        result = embed_greedy(em, settings);
+            all_embeddings[i] = std::make_unique<Embedding>(_em, all_inputs[i]); // copy
+            auto& em = *all_embeddings[i];
+
+            settings.progress.cancellation_token = &all_tokens[i];
+            result = embed_greedy(em, settings);
+            result.settings.progress.cancellation_token = _all_settings[i].progress.cancellation_token; // all_tokens are local
+
+            if (result.settings.use_swirl_detection)
+                result.algorithm += "_swirl";
+            if (result.settings.use_vertex_repulsive_tracing)
+                result.algorithm += "_repulsive";
+            if (result.settings.prefer_extremal_vertices)
+                result.algorithm += "_extremal";
+            if (result.settings.restricted_candidate_list_size > 1)
+                result.algorithm += "_rcl" + std::to_string(result.settings.restricted_candidate_list_size) + "_seed" + std::to_string(result.settings.seed);
+        }
+        catch (...) {
+            all_exceptions[i] = std::current_exception();
+        }
+    }
 
-        if (result.settings.use_swirl_detection)
-            result.algorithm += "_swirl";
-        if (result.settings.use_vertex_repulsive_tracing)
-            result.algorithm += "_repulsive";
-        if (result.settings.prefer_extremal_vertices)
-            result.algorithm += "_extremal";
+    for (const auto& exception : all_exceptions) {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
 
-        std::cout << "Embedding cost: " << result.cost << std::endl;
+    for (int i = 0; i < n; ++i) {
+        if (_all_settings[i].progress.verbose && all_embeddings[i]) {
+            std::cout << "Embedding cost: " << all_results[i].cost << std::endl;
+        }
     }
 
     int best_idx;
     const auto& best_result = best(all_results, best_idx);
 
-    std::cout << "Best settings:" << std::endl;
-    std::cout << std::boolalpha;
-    std::cout << "    use_swirl_detection: " << best_result.settings.use_swirl_detection << std::endl;
-    std::cout << "    use_vertex_repulsive_tracing: " << best_result.settings.use_vertex_repulsive_tracing << std::endl;
-    std::cout << "    prefer_extremal_vertices: " << best_result.settings.prefer_extremal_vertices << std::endl;
-    std::cout << "Best cost: " << best_result.cost << std::endl;
+    if (best_idx < 0) {
+        if (!_all_settings.empty() && _all_settings.front().progress.verbose) {
+            std::cout << "No greedy variant found a complete embedding." << std::endl;
+        }
+        return all_results;
+    }
+
+    if (best_result.settings.progress.verbose) {
+        std::cout << "Best settings:" << std::endl;
+        std::cout << std::boolalpha;
+        std::cout << "    use_swirl_detection: " << best_result.settings.use_swirl_detection << std::endl;
+        std::cout << "    use_vertex_repulsive_tracing: " << best_result.settings.use_vertex_repulsive_tracing << std::endl;
+        std::cout << "    prefer_extremal_vertices: " << best_result.settings.prefer_extremal_vertices << std::endl;
+        if (best_result.settings.restricted_candidate_list_size > 1) {
+            std::cout << "    restricted_candidate_list_size: " << best_result.settings.restricted_candidate_list_size << std::endl;
+            std::cout << "    seed: " << best_result.settings.seed << std::endl;
+        }
+        std::cout << "Best cost: " << best_result.cost << std::endl;
+    }
 
-    _em = all_embeddings[best_idx]; // copy
+    if (all_embeddings[best_idx]) {
+        _em.assign_keep_input(*all_embeddings[best_idx]); // copy
+    }
 
     return all_results;
 }
 
+}
+
+std::vector<GreedyResult> embed_greedy(Embedding& _em, const std::vector<GreedySettings>& _all_settings)
+{
+    return embed_greedy_parallel(_em, _all_settings, std::numeric_limits<double>::infinity());
+}
+
+std::vector<GreedyResult> embed_greedy_restarts(Embedding& _em, const GreedySettings& _settings, int _num_restarts, double _time_limit)
+{
+    LE_ASSERT_GEQ(_num_restarts, 1);
+
+    std::vector<GreedySettings> all_settings(_num_restarts, _settings);
+    for (int i = 0; i < _num_restarts; ++i) {
+        all_settings[i].seed = _settings.seed + i;
+    }
+
+    return embed_greedy_parallel(_em, all_settings, _time_limit);
+}
+
 std::vector<GreedyResult> embed_competitors(Embedding& _em, const GreedySettings& _settings)
 {
     std::vector<GreedySettings> all_settings;
@@ -534,7 +1111,15 @@ const GreedyResult& best(const std::vector<GreedyResult>& _results, int& best_id
             best_idx = i;
         }
     }
-    LE_ASSERT_GEQ(best_idx, 0);
+    if (best_idx < 0 && !_results.empty() && _results.front().cancelled) {
+        // No complete result available
+        best_idx = 0;
+    }
+    if (best_idx < 0) {
+        // All variants ran into a dead end
+        static const GreedyResult none;
+        return none;
+    }
 
     return _results[best_idx];
 }
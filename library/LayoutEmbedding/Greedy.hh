@@ -2,6 +2,7 @@
 
 #include <LayoutEmbedding/Embedding.hh>
 #include <LayoutEmbedding/InsertionSequence.hh>
+#include <LayoutEmbedding/Progress.hh>
 
 namespace LayoutEmbedding {
 
@@ -27,6 +28,15 @@ struct GreedySettings
     // Prefer insertion of edges that connect extremal vertices (with large average distance to neighbors) [Schreiner2004]
     bool prefer_extremal_vertices = false;
     double extremal_vertex_ratio = 0.25;
+
+    // Randomized candidate selection (GRASP) [Feo1995]: With BestFirst insertion order, each step picks uniformly at random
+    // among the restricted_candidate_list_size best candidates (after penalties). 1 yields the deterministic greedy algorithm.
+    int restricted_candidate_list_size = 1;
+    unsigned int seed = 0;
+
+    // Progress callbacks, cancellation and console output.
+    // A cancelled run leaves the embedding partially embedded and reports infinite cost.
+    ProgressObserver progress;
 };
 
 struct GreedyResult
@@ -40,9 +50,12 @@ struct GreedyResult
     GreedySettings settings;
     InsertionSequence insertion_sequence;
     double cost = std::numeric_limits<double>::infinity();
+    bool cancelled = false;
 };
 
-// Run a single greedy variant
+// Run a single greedy variant.
+// Paths that are already embedded are kept, only the remaining layout edges are embedded.
+// If none of them can be embedded anymore, the run stops early and reports infinite cost.
 GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings = GreedySettings(), const std::string& _name = "greedy");
 GreedyResult embed_praun(Embedding& _em, const GreedySettings& _settings = GreedySettings());
 GreedyResult embed_kraevoy(Embedding& _em, const GreedySettings& _settings = GreedySettings());
@@ -52,6 +65,15 @@ GreedyResult embed_schreiner(Embedding& _em, const GreedySettings& _settings = G
 std::vector<GreedyResult> embed_greedy(Embedding& _em, const std::vector<GreedySettings>& _all_settings);
 std::vector<GreedyResult> embed_competitors(Embedding& _em, const GreedySettings& _settings = GreedySettings());
 
+// Run _num_restarts randomized copies of _settings in parallel, with seeds _settings.seed, _settings.seed + 1, ...
+// (restricted_candidate_list_size has to be set by the caller).
+// Once _time_limit (seconds) has passed, running restarts are cancelled and no further ones are started.
+// Cancelled restarts (and those that were not run) are marked as cancelled.
+// Applies the best embedding to _em (if any restart found a complete one).
+std::vector<GreedyResult> embed_greedy_restarts(Embedding& _em, const GreedySettings& _settings, int _num_restarts, double _time_limit = std::numeric_limits<double>::infinity());
+
+// Result with the lowest (finite) cost. If there is none, returns the first result if it is cancelled,
+// and otherwise a default result (infinite cost, not cancelled) with best_idx = -1.
 const GreedyResult& best(const std::vector<GreedyResult>& _results);
 const GreedyResult& best(const std::vector<GreedyResult>& _results, int& best_idx);
 
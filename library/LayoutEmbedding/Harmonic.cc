@@ -1,22 +1,43 @@
 #include "Harmonic.hh"
 
+#include <LayoutEmbedding/Hash.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
+
+#include <glow-extras/timing/CpuTimer.hh>
+
+#include <Eigen/IterativeLinearSolvers>
+#include <Eigen/SparseCholesky>
 #include <Eigen/SparseLU>
 
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
 namespace LayoutEmbedding
 {
 
 namespace
 {
 
-/// Angle at to-vertex between given and next halfedge
-auto calc_sector_angle(
+/// Edge vectors at the to-vertex of the given halfedge: towards the to-vertex of the next halfedge and towards the from-vertex.
+std::pair<tg::dvec3, tg::dvec3> sector_vectors(
         const pm::vertex_attribute<tg::pos3>& _pos,
         const pm::halfedge_handle& _h)
 {
-    const auto v1 = _pos[_h.next().vertex_to()] - _pos[_h.vertex_to()];
-    const auto v2 = _pos[_h.vertex_from()] - _pos[_h.vertex_to()];
-    return tg::angle_between(v1, v2);
+    const tg::dpos3 p(_pos[_h.vertex_to()]);
+    return { tg::dpos3(_pos[_h.next().vertex_to()]) - p, tg::dpos3(_pos[_h.vertex_from()]) - p };
+}
+
+/// tan(angle / 2) of the angle between _a and _b, without trigonometric functions
+double tan_half_angle(const tg::dvec3& _a, const tg::dvec3& _b)
+{
+    return tg::length(tg::cross(_a, _b)) / (tg::length(_a) * tg::length(_b) + tg::dot(_a, _b));
+}
+
+/// cot of the angle between _a and _b, without trigonometric functions
+double cot_angle(const tg::dvec3& _a, const tg::dvec3& _b)
+{
+    return tg::dot(_a, _b) / tg::length(tg::cross(_a, _b));
 }
 
 double mean_value_weight(
@@ -26,86 +47,576 @@ double mean_value_weight(
     if (_h.edge().is_boundary())
         return 0.0;
 
-    const auto angle_l = calc_sector_angle(_pos, _h.prev());
-    const auto angle_r = calc_sector_angle(_pos, _h.opposite());
-    const auto edge_length = pm::edge_length(_h, _pos);
-    double w_ij = (tan(angle_l.radians() / 2.0) + tan(angle_r.radians() / 2.0)) / edge_length;
+    const auto [a_l, b_l] = sector_vectors(_pos, _h.prev());
+    const auto [a_r, b_r] = sector_vectors(_pos, _h.opposite());
+    const double edge_length = tg::length(a_l);
+    double w_ij = (tan_half_angle(a_l, b_l) + tan_half_angle(a_r, b_r)) / edge_length;
+
+    if (!(w_ij > 0.0)) // Also catches NaN of degenerate triangles
+        w_ij = 1e-5;
+
+    return w_ij;
+}
+
+/// Clamped to positive values (as mean_value_weight), which keeps the reduced system an M-matrix.
+double cotangent_weight(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::halfedge_handle& _h)
+{
+    double w_ij = 0.0;
+    for (const auto h : {_h, _h.opposite()})
+    {
+        if (!h.is_boundary())
+        {
+            // Angle opposite to the edge
+            const auto [a, b] = sector_vectors(_pos, h.next());
+            w_ij += 0.5 * cot_angle(a, b);
+        }
+    }
 
-    if (w_ij <= 0.0)
+    if (!(w_ij > 0.0))
         w_ij = 1e-5;
 
     return w_ij;
 }
 
+double laplace_weight(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::halfedge_handle& _h,
+        const LaplaceWeights _weights)
+{
+    if (_weights == LaplaceWeights::Uniform)
+        return 1.0;
+    else if (_weights == LaplaceWeights::MeanValue)
+        return mean_value_weight(_pos, _h);
+    else if (_weights == LaplaceWeights::Cotangent)
+        return cotangent_weight(_pos, _h);
+    else
+        LE_ERROR_THROW("");
 }
 
-bool harmonic(
+/// Smaller systems are assembled on a single thread (see assemble_reduced_laplacian).
+constexpr int min_vertices_parallel_assembly = 10000;
+
+/// Sorts the _n entries of a matrix row by column and sums up duplicate columns. Returns the new number of entries.
+int sort_and_merge_row(int* _cols, double* _values, const int _n)
+{
+    // Insertion sort, rows are short
+    for (int a = 1; a < _n; ++a)
+    {
+        for (int b = a; b > 0 && _cols[b - 1] > _cols[b]; --b)
+        {
+            std::swap(_cols[b - 1], _cols[b]);
+            std::swap(_values[b - 1], _values[b]);
+        }
+    }
+
+    int k = 0;
+    for (int a = 0; a < _n; ++a)
+    {
+        if (k > 0 && _cols[k - 1] == _cols[a])
+        {
+            _values[k - 1] += _values[a];
+        }
+        else
+        {
+            _cols[k] = _cols[a];
+            _values[k] = _values[a];
+            ++k;
+        }
+    }
+    return k;
+}
+
+bool use_cholesky(const HarmonicSettings& _settings)
+{
+    if (!is_symmetric(_settings.weights))
+        return false;
+
+    return _settings.solver == HarmonicSolver::Automatic || _settings.solver == HarmonicSolver::Cholesky;
+}
+
+/// Solves with a factorized direct solver.
+/// The triangular solves of different columns are independent and run in parallel chunks of _chunk_size.
+template <typename Solver>
+bool solve_factorized(
+        const Solver& _solver,
+        const Eigen::MatrixXd& _rhs,
+        Eigen::MatrixXd& _x,
+        const int _chunk_size)
+{
+    const int d = _rhs.cols();
+    if (_chunk_size <= 0 || d <= _chunk_size)
+    {
+        _x = _solver.solve(_rhs);
+        return _solver.info() == Eigen::Success;
+    }
+
+    _x.resize(_rhs.rows(), d);
+    const int n_chunks = (d + _chunk_size - 1) / _chunk_size;
+    #pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < n_chunks; ++c)
+    {
+        const int begin = c * _chunk_size;
+        const int size = std::min(_chunk_size, d - begin);
+        _x.middleCols(begin, size) = _solver.solve(_rhs.middleCols(begin, size));
+    }
+
+    return _solver.info() == Eigen::Success;
+}
+
+template <typename Solver>
+bool factorize_and_solve(
+        Solver& _solver,
+        const Eigen::SparseMatrix<double>& _A,
+        const Eigen::MatrixXd& _rhs,
+        Eigen::MatrixXd& _x,
+        const int _chunk_size)
+{
+    _solver.compute(_A);
+    if (_solver.info() != Eigen::Success)
+        return false;
+
+    return solve_factorized(_solver, _rhs, _x, _chunk_size);
+}
+
+/// Solves _L * _x = _rhs. Falls back to LU if the Cholesky factorization fails.
+bool solve_reduced(
+        const Eigen::SparseMatrix<double>& _L,
+        const Eigen::MatrixXd& _rhs,
+        Eigen::MatrixXd& _x,
+        const bool _cholesky,
+        HarmonicSolverCache* _cache,
+        const int _chunk_size)
+{
+    if (_cache)
+        return (_cholesky && _cache->solve(_L, _rhs, _x, true, _chunk_size)) || _cache->solve(_L, _rhs, _x, false, _chunk_size);
+
+    if (_cholesky)
+    {
+        Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver;
+        if (factorize_and_solve(solver, _L, _rhs, _x, _chunk_size))
+            return true;
+    }
+
+    Eigen::SparseLU<Eigen::SparseMatrix<double>> solver;
+    return factorize_and_solve(solver, _L, _rhs, _x, _chunk_size);
+}
+
+template <typename Solver>
+bool solve_iterative(
+        Solver& _solver,
+        const Eigen::SparseMatrix<double>& _L,
+        const Eigen::MatrixXd& _rhs,
+        Eigen::MatrixXd& _x,
+        const HarmonicSettings& _settings)
+{
+    _solver.setTolerance(_settings.iterative_tolerance);
+    _solver.setMaxIterations(_settings.iterative_max_iterations);
+    _solver.compute(_L);
+    if (_solver.info() != Eigen::Success)
+        return false;
+
+    // Columns are solved separately, each starting from its initial guess
+    for (int k = 0; k < _rhs.cols(); ++k)
+    {
+        _x.col(k) = _solver.solveWithGuess(_rhs.col(k), _x.col(k));
+        if (_solver.info() != Eigen::Success)
+            return false;
+    }
+
+    return true;
+}
+
+/// Solves _L * _x = _rhs iteratively, starting from the given _x.
+bool solve_iterative(
+        const Eigen::SparseMatrix<double>& _L,
+        const Eigen::MatrixXd& _rhs,
+        Eigen::MatrixXd& _x,
+        const HarmonicSettings& _settings)
+{
+    if (is_symmetric(_settings.weights))
+    {
+        Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Lower | Eigen::Upper, Eigen::IncompleteCholesky<double>> solver;
+        return solve_iterative(solver, _L, _rhs, _x, _settings);
+    }
+    else
+    {
+        Eigen::BiCGSTAB<Eigen::SparseMatrix<double>, Eigen::IncompleteLUT<double>> solver;
+        return solve_iterative(solver, _L, _rhs, _x, _settings);
+    }
+}
+
+HashValue hash_pattern(const Eigen::SparseMatrix<double>& _A)
+{
+    HashValue h = hash(_A.rows());
+    for (int i = 0; i <= _A.outerSize(); ++i)
+        h = hash_combine(h, hash(_A.outerIndexPtr()[i]));
+    for (int i = 0; i < _A.nonZeros(); ++i)
+        h = hash_combine(h, hash(_A.innerIndexPtr()[i]));
+    return h;
+}
+
+bool same_pattern(const Eigen::SparseMatrix<double>& _A, const Eigen::SparseMatrix<double>& _B)
+{
+    return _A.rows() == _B.rows()
+        && _A.nonZeros() == _B.nonZeros()
+        && std::equal(_A.outerIndexPtr(), _A.outerIndexPtr() + _A.outerSize() + 1, _B.outerIndexPtr())
+        && std::equal(_A.innerIndexPtr(), _A.innerIndexPtr() + _A.nonZeros(), _B.innerIndexPtr());
+}
+
+bool same_values(const Eigen::SparseMatrix<double>& _A, const Eigen::SparseMatrix<double>& _B)
+{
+    return std::equal(_A.valuePtr(), _A.valuePtr() + _A.nonZeros(), _B.valuePtr());
+}
+
+}
+
+struct HarmonicSolverCache::Entry
+{
+    HashValue hash;
+    bool cholesky;
+    Eigen::SparseMatrix<double> A; // Most recently factorized matrix
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> ldlt;
+    Eigen::SparseLU<Eigen::SparseMatrix<double>> lu;
+    double t_analyze = 0.0;
+    double t_factorize = 0.0;
+    int last_used = 0;
+
+    void analyze()
+    {
+        glow::timing::CpuTimer timer;
+        if (cholesky)
+            ldlt.analyzePattern(A);
+        else
+            lu.analyzePattern(A);
+        t_analyze = timer.elapsedSecondsD();
+    }
+
+    bool factorize()
+    {
+        glow::timing::CpuTimer timer;
+        bool success;
+        if (cholesky)
+        {
+            ldlt.factorize(A);
+            success = ldlt.info() == Eigen::Success;
+        }
+        else
+        {
+            lu.factorize(A);
+            success = lu.info() == Eigen::Success;
+        }
+        t_factorize = timer.elapsedSecondsD();
+        return success;
+    }
+
+    bool solve(const Eigen::MatrixXd& _rhs, Eigen::MatrixXd& _x, const int _chunk_size) const
+    {
+        if (cholesky)
+            return solve_factorized(ldlt, _rhs, _x, _chunk_size);
+        else
+            return solve_factorized(lu, _rhs, _x, _chunk_size);
+    }
+};
+
+HarmonicSolverCache::HarmonicSolverCache(const int _max_entries) :
+    max_entries(_max_entries)
+{
+    LE_ASSERT_GEQ(max_entries, 1);
+}
+
+HarmonicSolverCache::~HarmonicSolverCache() = default;
+
+bool HarmonicSolverCache::solve(const Eigen::SparseMatrix<double>& _A, const Eigen::MatrixXd& _rhs, Eigen::MatrixXd& _x, const bool _cholesky, const int _rhs_chunk_size)
+{
+    LE_ASSERT(_A.isCompressed());
+    ++stats_.num_solves;
+    ++clock;
+
+    const HashValue h = hash_pattern(_A);
+    auto it = std::find_if(entries.begin(), entries.end(), [&] (const auto& e) {
+        return e->hash == h && e->cholesky == _cholesky && same_pattern(e->A, _A);
+    });
+
+    if (it != entries.end())
+    {
+        Entry& entry = **it;
+        entry.last_used = clock;
+        ++stats_.num_pattern_hits;
+        if (same_values(entry.A, _A))
+        {
+            ++stats_.num_factorization_hits;
+            stats_.t_saved += entry.t_analyze + entry.t_factorize;
+        }
+        else
+        {
+            stats_.t_saved += entry.t_analyze;
+            entry.A = _A;
+            if (!entry.factorize())
+            {
+                entries.erase(it);
+                return false;
+            }
+        }
+        return entry.solve(_rhs, _x, _rhs_chunk_size);
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->hash = h;
+    entry->cholesky = _cholesky;
+    entry->A = _A;
+    entry->last_used = clock;
+    entry->analyze();
+    if (!entry->factorize())
+        return false;
+    if (!entry->solve(_rhs, _x, _rhs_chunk_size))
+        return false;
+
+    // Evict the least recently used entry
+    if ((int)entries.size() >= max_entries)
+    {
+        entries.erase(std::min_element(entries.begin(), entries.end(), [] (const auto& a, const auto& b) {
+            return a->last_used < b->last_used;
+        }));
+    }
+    entries.push_back(std::move(entry));
+
+    return true;
+}
+
+void HarmonicSolverCache::clear()
+{
+    entries.clear();
+}
+
+bool is_symmetric(const LaplaceWeights _weights)
+{
+    return _weights == LaplaceWeights::Uniform || _weights == LaplaceWeights::Cotangent;
+}
+
+void assemble_reduced_laplacian(
         const pm::vertex_attribute<tg::pos3>& _pos,
         const pm::vertex_attribute<bool>& _constrained,
         const Eigen::MatrixXd& _constraint_values,
-        Eigen::MatrixXd& _res,
         const LaplaceWeights _weights,
-        const bool _fallback_iterative)
+        const bool _parallel,
+        Eigen::SparseMatrix<double>& _L,
+        Eigen::MatrixXd& _rhs,
+        std::vector<int>& _free_idx)
 {
-    LE_ASSERT(_pos.mesh().is_compact());
+    const pm::Mesh& m = _pos.mesh();
+    LE_ASSERT(m.is_compact());
 
-    const int n = _pos.mesh().vertices().size();
+    const int n = m.vertices().size();
     const int d = _constraint_values.cols();
     LE_ASSERT_EQ(_constraint_values.rows(), n);
 
-    // Set up Laplace matrix and rhs
-    Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero(n, d);
-    std::vector<Eigen::Triplet<double>> triplets;
-    for (auto v : _pos.mesh().vertices())
+    // Number the free vertices
+    _free_idx.assign(n, -1);
+    std::vector<int> free_vertices;
+    for (auto v : m.vertices())
     {
-        const int i = v.idx.value;
-
-        if (_constrained[v])
+        if (!_constrained[v])
         {
-            triplets.push_back(Eigen::Triplet<double>(i, i, 1.0));
-            rhs.row(i) = _constraint_values.row(i);
+            _free_idx[v.idx.value] = free_vertices.size();
+            free_vertices.push_back(v.idx.value);
         }
-        else
+    }
+    const int n_free = free_vertices.size();
+
+    // Set up Laplace matrix (positive diagonal) of the free vertices.
+    // Constrained neighbors are moved to the rhs.
+    _rhs = Eigen::MatrixXd::Zero(n_free, d);
+
+    if (!_parallel)
+    {
+        std::vector<Eigen::Triplet<double>> triplets;
+        for (int i = 0; i < n_free; ++i)
         {
+            const auto v = m.vertices()[free_vertices[i]];
             LE_ASSERT(!v.is_boundary());
 
             for (auto h : v.outgoing_halfedges())
             {
-                const int j = h.vertex_to().idx.value;
-                double w_ij;
-                if (_weights == LaplaceWeights::Uniform)
-                    w_ij = 1.0;
-                else if (_weights == LaplaceWeights::MeanValue)
-                    w_ij = mean_value_weight(_pos, h);
+                const double w_ij = laplace_weight(_pos, h, _weights);
+                const int j = _free_idx[h.vertex_to().idx.value];
+                if (j >= 0)
+                    triplets.push_back(Eigen::Triplet<double>(i, j, -w_ij));
                 else
-                    LE_ERROR_THROW("");
+                    _rhs.row(i) += w_ij * _constraint_values.row(h.vertex_to().idx.value);
+                triplets.push_back(Eigen::Triplet<double>(i, i, w_ij));
+            }
+        }
 
-                triplets.push_back(Eigen::Triplet<double>(i, j, w_ij));
-                triplets.push_back(Eigen::Triplet<double>(i, i, -w_ij));
+        _L.resize(n_free, n_free);
+        _L.setFromTriplets(triplets.begin(), triplets.end());
+        return;
+    }
+
+    // Each row has at most valence + 1 entries. Rows are filled independently into this layout,
+    // then compacted into a compressed row-major matrix.
+    std::vector<int> row_begin(n_free + 1, 0);
+    for (int i = 0; i < n_free; ++i)
+    {
+        int valence = 0;
+        for (auto h : m.vertices()[free_vertices[i]].outgoing_halfedges())
+        {
+            (void)h;
+            ++valence;
+        }
+        row_begin[i + 1] = row_begin[i] + valence + 1;
+    }
+
+    std::vector<int> cols(row_begin[n_free]);
+    std::vector<double> values(row_begin[n_free]);
+    std::vector<int> row_size(n_free);
+    std::atomic<bool> boundary_vertex = false;
+
+    #pragma omp parallel for schedule(static) if(n_free >= min_vertices_parallel_assembly)
+    for (int i = 0; i < n_free; ++i)
+    {
+        const auto v = m.vertices()[free_vertices[i]];
+        if (v.is_boundary())
+        {
+            boundary_vertex = true;
+            continue;
+        }
+
+        int* c = cols.data() + row_begin[i];
+        double* w = values.data() + row_begin[i];
+        int k = 0;
+        double diagonal = 0.0;
+        for (auto h : v.outgoing_halfedges())
+        {
+            const double w_ij = laplace_weight(_pos, h, _weights);
+            diagonal += w_ij;
+            const int j = _free_idx[h.vertex_to().idx.value];
+            if (j >= 0)
+            {
+                c[k] = j;
+                w[k] = -w_ij;
+                ++k;
+            }
+            else
+            {
+                _rhs.row(i) += w_ij * _constraint_values.row(h.vertex_to().idx.value);
             }
         }
+        c[k] = i;
+        w[k] = diagonal;
+        ++k;
+
+        row_size[i] = sort_and_merge_row(c, w, k);
     }
+    LE_ASSERT(!boundary_vertex);
 
-    Eigen::SparseMatrix<double> L(n, n);
-    L.setFromTriplets(triplets.begin(), triplets.end());
+    std::vector<int> outer(n_free + 1, 0);
+    for (int i = 0; i < n_free; ++i)
+        outer[i + 1] = outer[i] + row_size[i];
 
-    Eigen::SparseLU<Eigen::SparseMatrix<double>> solver;
-    solver.compute(L);
-    if (solver.info() == Eigen::Success)
+    std::vector<int> inner(outer[n_free]);
+    std::vector<double> compact_values(outer[n_free]);
+    #pragma omp parallel for schedule(static) if(n_free >= min_vertices_parallel_assembly)
+    for (int i = 0; i < n_free; ++i)
     {
-        _res = solver.solve(rhs);
-        if (solver.info() == Eigen::Success)
-            return true;
+        std::copy_n(cols.data() + row_begin[i], row_size[i], inner.data() + outer[i]);
+        std::copy_n(values.data() + row_begin[i], row_size[i], compact_values.data() + outer[i]);
+    }
+
+    const Eigen::Map<const Eigen::SparseMatrix<double, Eigen::RowMajor>> L_rows(
+                n_free, n_free, outer[n_free], outer.data(), inner.data(), compact_values.data());
+    _L = L_rows; // Converts to column-major storage
+}
+
+bool harmonic(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::vertex_attribute<bool>& _constrained,
+        const Eigen::MatrixXd& _constraint_values,
+        Eigen::MatrixXd& _res,
+        const HarmonicSettings& _settings)
+{
+    LE_ASSERT(_pos.mesh().is_compact());
+
+    const int n = _pos.mesh().vertices().size();
+    const int d = _constraint_values.cols();
+    LE_ASSERT_EQ(_constraint_values.rows(), n);
+
+    Eigen::SparseMatrix<double> L;
+    Eigen::MatrixXd rhs;
+    std::vector<int> free_idx;
+    assemble_reduced_laplacian(_pos, _constrained, _constraint_values, _settings.weights, _settings.parallel_assembly, L, rhs, free_idx);
+    const int n_free = L.rows();
+
+    if (n_free == 0)
+    {
+        _res = _constraint_values;
+        return true;
     }
 
-    std::cout << "LU solve failed" << std::endl;
+    // Initial guess of the iterative solver
+    Eigen::MatrixXd x = Eigen::MatrixXd::Zero(n_free, d);
+    if (_settings.initial_guess)
+    {
+        LE_ASSERT_EQ(_settings.initial_guess->rows(), n);
+        LE_ASSERT_EQ(_settings.initial_guess->cols(), d);
+        for (int v = 0; v < n; ++v)
+        {
+            if (free_idx[v] >= 0)
+                x.row(free_idx[v]) = _settings.initial_guess->row(v);
+        }
+    }
 
-    if (_fallback_iterative)
+    if (_settings.solver == HarmonicSolver::Iterative)
     {
-        std::cout << "Falling back to iterative solver" << std::endl;
+        if (!solve_iterative(L, rhs, x, _settings))
+        {
+            std::cout << "Iterative solve failed" << std::endl;
+            return false;
+        }
     }
+    else
+    {
+        const Eigen::MatrixXd x_guess = x;
+        if (!solve_reduced(L, rhs, x, use_cholesky(_settings), _settings.cache, _settings.rhs_chunk_size))
+        {
+            std::cout << "Sparse solve failed" << std::endl;
 
-    return false;
+            if (!_settings.fallback_iterative)
+                return false;
+
+            std::cout << "Falling back to iterative solver" << std::endl;
+            x = x_guess;
+            if (!solve_iterative(L, rhs, x, _settings))
+            {
+                std::cout << "Iterative solve failed" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    _res = _constraint_values;
+    for (int v = 0; v < n; ++v)
+    {
+        if (free_idx[v] >= 0)
+            _res.row(v) = x.row(free_idx[v]);
+    }
+
+    return true;
+}
+
+bool harmonic(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::vertex_attribute<bool>& _constrained,
+        const Eigen::MatrixXd& _constraint_values,
+        Eigen::MatrixXd& _res,
+        const LaplaceWeights _weights,
+        const bool _fallback_iterative)
+{
+    HarmonicSettings settings;
+    settings.weights = _weights;
+    settings.fallback_iterative = _fallback_iterative;
+    return harmonic(_pos, _constrained, _constraint_values, _res, settings);
 }
 
 bool harmonic_parametrization(
@@ -113,8 +624,7 @@ bool harmonic_parametrization(
         const pm::vertex_attribute<bool>& _constrained,
         const VertexParam& _constraint_values,
         VertexParam& _res,
-        const LaplaceWeights _weights,
-        const bool _fallback_iterative)
+        const HarmonicSettings& _settings)
 {
     const int n = _pos.mesh().vertices().size();
     const int d = 2;
@@ -126,7 +636,7 @@ bool harmonic_parametrization(
 
     // Compute
     Eigen::MatrixXd res_mat;
-    if (!harmonic(_pos, _constrained, constraint_values, res_mat, _weights, _fallback_iterative))
+    if (!harmonic(_pos, _constrained, constraint_values, res_mat, _settings))
         return false;
 
     // Convert result
@@ -137,4 +647,18 @@ bool harmonic_parametrization(
     return true;
 }
 
+bool harmonic_parametrization(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::vertex_attribute<bool>& _constrained,
+        const VertexParam& _constraint_values,
+        VertexParam& _res,
+        const LaplaceWeights _weights,
+        const bool _fallback_iterative)
+{
+    HarmonicSettings settings;
+    settings.weights = _weights;
+    settings.fallback_iterative = _fallback_iterative;
+    return harmonic_parametrization(_pos, _constrained, _constraint_values, _res, settings);
+}
+
 }
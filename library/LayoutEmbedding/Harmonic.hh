@@ -1,10 +1,14 @@
 #pragma once
 
 #include <Eigen/Dense>
+#include <Eigen/SparseCore>
 #include <polymesh/pm.hh>
 #include <typed-geometry/tg.hh>
 #include <LayoutEmbedding/Parametrization.hh>
 
+#include <memory>
+#include <vector>
+
 namespace LayoutEmbedding
 {
 
@@ -12,9 +16,114 @@ enum class LaplaceWeights
 {
     Uniform,
     MeanValue,
+    Cotangent, // Non-positive weights are clamped to a small positive value
+};
+
+/// Uniform and cotangent weights yield a symmetric positive definite system.
+bool is_symmetric(const LaplaceWeights _weights);
+
+enum class HarmonicSolver
+{
+    Automatic, // Cholesky for symmetric weights, LU otherwise
+    LU,
+    Cholesky, // Falls back to LU if the weights are not symmetric
+    Iterative, // Conjugate gradients (symmetric weights) or BiCGSTAB, see HarmonicSettings
+};
+
+/// Keeps the factorizations of recent systems, so repeated solves on the same region
+/// (same connectivity and constrained vertices, i.e. the same sparsity pattern) skip the symbolic analysis,
+/// and also the numeric factorization if the weights did not change either.
+/// Not thread-safe. Use one cache per thread.
+class HarmonicSolverCache
+{
+public:
+    explicit HarmonicSolverCache(const int _max_entries = 8);
+    ~HarmonicSolverCache();
+
+    struct Stats
+    {
+        int num_solves = 0;
+        int num_pattern_hits = 0; // Symbolic analysis reused
+        int num_factorization_hits = 0; // Symbolic analysis and numeric factorization reused
+        double t_saved = 0.0; // Seconds, measured when the reused analysis / factorization was computed
+
+        double hit_rate() const { return num_solves > 0 ? (double)num_pattern_hits / num_solves : 0.0; }
+
+        Stats& operator+=(const Stats& _other)
+        {
+            num_solves += _other.num_solves;
+            num_pattern_hits += _other.num_pattern_hits;
+            num_factorization_hits += _other.num_factorization_hits;
+            t_saved += _other.t_saved;
+            return *this;
+        }
+    };
+    const Stats& stats() const { return stats_; }
+
+    /// Solves _A * _x = _rhs with SimplicialLDLT (_cholesky) or SparseLU.
+    /// If _rhs_chunk_size > 0, the columns are solved in parallel chunks of this size.
+    bool solve(const Eigen::SparseMatrix<double>& _A, const Eigen::MatrixXd& _rhs, Eigen::MatrixXd& _x, const bool _cholesky, const int _rhs_chunk_size = 0);
+
+    void clear();
+
+private:
+    struct Entry;
+    std::vector<std::unique_ptr<Entry>> entries;
+    int max_entries;
+    int clock = 0;
+    Stats stats_;
 };
 
-/// Compute harmonic field using mean-value weights.
+struct HarmonicSettings
+{
+    LaplaceWeights weights = LaplaceWeights::MeanValue;
+    HarmonicSolver solver = HarmonicSolver::Automatic;
+    /// Use the iterative solver if the direct solve fails.
+    bool fallback_iterative = false;
+
+    /// Optional. Not owned.
+    HarmonicSolverCache* cache = nullptr;
+
+    /// If > 0, the columns of the right-hand side are solved in parallel chunks of this size (direct solvers only).
+    int rhs_chunk_size = 0;
+
+    /// Compute the matrix rows of large systems in parallel (see assemble_reduced_laplacian).
+    bool parallel_assembly = true;
+
+    /// Iterative solver: Conjugate gradients with incomplete Cholesky preconditioner for symmetric weights,
+    /// BiCGSTAB with incomplete LU preconditioner otherwise.
+    double iterative_tolerance = 1e-8; // Relative residual
+    int iterative_max_iterations = 1000;
+
+    /// Optional initial guess for the iterative solver (one row per vertex, as the constraint values),
+    /// e.g. the result of a previous solve on a similar region. Not owned.
+    const Eigen::MatrixXd* initial_guess = nullptr;
+};
+
+/// Laplace matrix (positive diagonal) of the free vertices. Constrained neighbors are moved to the rhs.
+/// Row i of _L and _rhs corresponds to the vertex with _free_idx[vertex index] == i (-1 for constrained vertices).
+/// With _parallel, rows are computed concurrently and written directly into the compressed matrix,
+/// otherwise the matrix is built from triplets.
+void assemble_reduced_laplacian(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::vertex_attribute<bool>& _constrained,
+        const Eigen::MatrixXd& _constraint_values,
+        const LaplaceWeights _weights,
+        const bool _parallel,
+        Eigen::SparseMatrix<double>& _L,
+        Eigen::MatrixXd& _rhs,
+        std::vector<int>& _free_idx);
+
+/// Compute harmonic field.
+/// Constrained vertices are eliminated, i.e. only the free vertices are solved for.
+bool harmonic(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::vertex_attribute<bool>& _constrained,
+        const Eigen::MatrixXd& _constraint_values,
+        Eigen::MatrixXd& _res,
+        const HarmonicSettings& _settings);
+
+/// Compute harmonic field using the given weights.
 bool harmonic(
         const pm::vertex_attribute<tg::pos3>& _pos,
         const pm::vertex_attribute<bool>& _constrained,
@@ -23,7 +132,15 @@ bool harmonic(
         const LaplaceWeights _weights,
         const bool _fallback_iterative = false);
 
-/// Compute harmonic field using mean-value weights.
+/// Compute harmonic parametrization.
+bool harmonic_parametrization(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::vertex_attribute<bool>& _constrained,
+        const VertexParam& _constraint_values,
+        VertexParam& _res,
+        const HarmonicSettings& _settings);
+
+/// Compute harmonic parametrization using the given weights.
 bool harmonic_parametrization(
         const pm::vertex_attribute<tg::pos3>& _pos,
         const pm::vertex_attribute<bool>& _constrained,
@@ -0,0 +1,379 @@
+#include "LandmarkEditing.hh"
+
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <algorithm>
+#include <optional>
+#include <set>
+
+namespace LayoutEmbedding {
+
+namespace {
+
+struct RemovedPath
+{
+    pm::edge_handle l_e;
+    VirtualPath path; // Pure vertex path, oriented like l_e.halfedgeA()
+};
+
+/// Unembeds all embedded edges in _l_edges and returns their paths.
+std::vector<RemovedPath> unembed_edges(Embedding& _em, const std::vector<pm::edge_handle>& _l_edges)
+{
+    std::vector<RemovedPath> removed;
+    for (const auto l_e : _l_edges) {
+        if (!_em.is_embedded(l_e)) {
+            continue;
+        }
+        RemovedPath r;
+        r.l_e = l_e;
+        for (const auto t_v : _em.get_embedded_path(l_e.halfedgeA())) {
+            r.path.push_back(VirtualVertex(t_v));
+        }
+        _em.unembed_path(l_e);
+        removed.push_back(r);
+    }
+    return removed;
+}
+
+/// Unembedding keeps all vertices of the target mesh, so the removed paths can be embedded again as they were.
+void restore_edges(Embedding& _em, const std::vector<RemovedPath>& _removed)
+{
+    for (const auto& r : _removed) {
+        _em.embed_path(r.l_e.halfedgeA(), r.path);
+    }
+}
+
+/// Embeds all unembedded layout edges with the greedy algorithm, keeping the embedded ones.
+/// Returns false if they cannot be embedded (or the run was cancelled).
+/// In that case, the paths embedded by this call are unembedded again.
+bool embed_remaining(Embedding& _em, const LandmarkEditSettings& _settings)
+{
+    std::set<pm::edge_index> unembedded;
+    for (const auto l_e : _em.layout_mesh().edges()) {
+        if (!_em.is_embedded(l_e)) {
+            unembedded.insert(l_e.idx);
+        }
+    }
+
+    const auto result = embed_greedy(_em, _settings.greedy_settings, "landmark_edit");
+    if (!result.cancelled && _em.is_complete()) {
+        return true;
+    }
+
+    for (const auto& l_ei : unembedded) {
+        if (_em.is_embedded(l_ei)) {
+            _em.unembed_path(_em.layout_mesh().edges()[l_ei]);
+        }
+    }
+    return false;
+}
+
+/// Changing the matching discards the vertex repulsive energy, which is expensive to recompute (one harmonic field per landmark).
+/// If the settings use it, edits that change the matching keep a copy of the embedding (as embed_greedy does anyway),
+/// so a failed edit can restore the energy of the previous matching along with the paths.
+std::optional<Embedding> backup_for_rollback(const Embedding& _em, const LandmarkEditSettings& _settings)
+{
+    if (_settings.greedy_settings.use_vertex_repulsive_tracing) {
+        return _em;
+    }
+    return std::nullopt;
+}
+
+/// Layout edges whose paths pass through the target vertex _t_v.
+std::vector<pm::edge_handle> paths_through(const Embedding& _em, const pm::vertex_handle& _t_v)
+{
+    std::vector<pm::edge_handle> l_edges;
+    for (const auto t_he : _t_v.outgoing_halfedges()) {
+        const auto l_he = _em.matching_layout_halfedge(t_he);
+        if (l_he.is_valid()) {
+            l_edges.push_back(l_he.edge());
+        }
+    }
+    return l_edges;
+}
+
+std::vector<pm::edge_handle> unique_edges(const std::vector<pm::edge_handle>& _l_edges)
+{
+    std::set<pm::edge_index> seen;
+    std::vector<pm::edge_handle> result;
+    for (const auto l_e : _l_edges) {
+        if (seen.insert(l_e.idx).second) {
+            result.push_back(l_e);
+        }
+    }
+    return result;
+}
+
+pm::edge_handle edge_between(const pm::vertex_handle& _l_v0, const pm::vertex_handle& _l_v1)
+{
+    for (const auto l_he : _l_v0.outgoing_halfedges()) {
+        if (l_he.vertex_to() == _l_v1) {
+            return l_he.edge();
+        }
+    }
+    return pm::edge_handle::invalid;
+}
+
+bool has_duplicates(const std::vector<pm::vertex_handle>& _l_vertices)
+{
+    std::set<pm::vertex_index> seen;
+    for (const auto l_v : _l_vertices) {
+        if (!seen.insert(l_v.idx).second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Whether the target vertex _t_v lies inside the patch of the layout face _l_f.
+/// False if the boundary of _l_f is not completely embedded.
+bool is_inside_patch(const Embedding& _em, const pm::face_handle& _l_f, const pm::vertex_handle& _t_v)
+{
+    for (const auto l_he : _l_f.halfedges()) {
+        if (!_em.is_embedded(l_he)) {
+            return false;
+        }
+    }
+    std::set<pm::face_index> patch;
+    for (const auto t_f : _em.get_patch(_l_f)) {
+        patch.insert(t_f.idx);
+    }
+    for (const auto t_f : _t_v.faces()) {
+        if (t_f.is_valid() && patch.count(t_f.idx)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+bool reembed_edges(Embedding& _em, const std::vector<pm::edge_handle>& _l_edges, const LandmarkEditSettings& _settings)
+{
+    LE_ASSERT(_em.is_complete());
+
+    const auto removed = unembed_edges(_em, unique_edges(_l_edges));
+    if (!embed_remaining(_em, _settings)) {
+        restore_edges(_em, removed);
+        return false;
+    }
+    return true;
+}
+
+bool move_landmark(Embedding& _em, const pm::vertex_handle& _l_v, const pm::vertex_handle& _t_v, const LandmarkEditSettings& _settings)
+{
+    LE_ASSERT(_l_v.mesh == &_em.layout_mesh());
+    LE_ASSERT(_t_v.mesh == &_em.target_mesh());
+    LE_ASSERT(_em.is_complete());
+
+    const auto t_v_old = _em.matching_target_vertex(_l_v);
+    if (t_v_old == _t_v) {
+        return true;
+    }
+    if (_em.matching_layout_vertex(_t_v).is_valid() || _t_v.is_boundary()) {
+        return false;
+    }
+
+    // Affected paths: The ones incident to _l_v and the ones blocking _t_v
+    auto affected = paths_through(_em, _t_v);
+    for (const auto l_e : _l_v.edges()) {
+        affected.push_back(l_e);
+    }
+
+    const auto backup = backup_for_rollback(_em, _settings);
+    const auto removed = unembed_edges(_em, unique_edges(affected));
+    _em.set_matching_target_vertex(_l_v, _t_v);
+
+    if (!embed_remaining(_em, _settings)) {
+        if (backup) {
+            _em = *backup;
+        }
+        else {
+            _em.set_matching_target_vertex(_l_v, t_v_old);
+            restore_edges(_em, removed);
+        }
+        return false;
+    }
+    return true;
+}
+
+pm::vertex_handle add_layout_vertex(Embedding& _em, const pm::face_handle& _l_f, const pm::vertex_handle& _t_v, const LandmarkEditSettings& _settings)
+{
+    LE_ASSERT(_l_f.mesh == &_em.layout_mesh());
+    LE_ASSERT(_t_v.mesh == &_em.target_mesh());
+    LE_ASSERT(_em.is_complete());
+
+    if (_em.matching_layout_vertex(_t_v).is_valid() || _t_v.is_boundary()) {
+        return pm::vertex_handle::invalid;
+    }
+
+    // Affected paths: The ones blocking _t_v and (if _t_v lies outside of the patch) the boundary of _l_f
+    auto affected = paths_through(_em, _t_v);
+    if (!is_inside_patch(_em, _l_f, _t_v)) {
+        for (const auto l_e : _l_f.edges()) {
+            affected.push_back(l_e);
+        }
+    }
+    const auto backup = backup_for_rollback(_em, _settings);
+    const auto removed = unembed_edges(_em, unique_edges(affected));
+
+    // Replace _l_f by a fan of triangles around the new vertex
+    pm::Mesh& l_m = _em.layout_mesh();
+    const auto l_f_vertices = _l_f.vertices().to_vector();
+    l_m.faces().remove(_l_f);
+    const auto l_v = l_m.vertices().add();
+    for (int i = 0; i < l_f_vertices.size(); ++i) {
+        l_m.faces().add(l_f_vertices[i], l_f_vertices[(i + 1) % l_f_vertices.size()], l_v);
+    }
+    _em.layout_pos()[l_v] = _em.target_pos()[_t_v];
+    _em.set_matching_target_vertex(l_v, _t_v);
+
+    if (!embed_remaining(_em, _settings)) {
+        _em.unmatch_layout_vertex(l_v);
+        l_m.vertices().remove(l_v);
+        l_m.faces().add(l_f_vertices);
+        if (backup) {
+            _em = *backup;
+        }
+        else {
+            restore_edges(_em, removed);
+        }
+        return pm::vertex_handle::invalid;
+    }
+    return l_v;
+}
+
+bool remove_layout_vertex(Embedding& _em, const pm::vertex_handle& _l_v)
+{
+    LE_ASSERT(_l_v.mesh == &_em.layout_mesh());
+
+    if (_l_v.is_boundary()) {
+        return false;
+    }
+
+    // Collect the vertices of the merged face, oriented like the adjacent faces:
+    // For each outgoing halfedge v -> a, the face of the halfedge contributes its vertices from a up to (excluding) the last one before v,
+    // which is the start of the next face (around the outgoing halfedge l_he.prev().opposite()).
+    std::vector<pm::vertex_handle> l_ring;
+    int valence = 0;
+    const auto l_he_start = _l_v.any_outgoing_halfedge();
+    auto l_he = l_he_start;
+    do {
+        auto l_he_face = l_he;
+        while (l_he_face.next().vertex_to() != _l_v) {
+            l_ring.push_back(l_he_face.vertex_to());
+            l_he_face = l_he_face.next();
+        }
+        l_he = l_he.prev().opposite();
+        ++valence;
+    } while (l_he != l_he_start);
+    if (valence < 3 || has_duplicates(l_ring)) {
+        return false;
+    }
+
+    for (const auto l_e : _l_v.edges()) {
+        if (_em.is_embedded(l_e)) {
+            _em.unembed_path(l_e);
+        }
+    }
+    _em.unmatch_layout_vertex(_l_v);
+
+    pm::Mesh& l_m = _em.layout_mesh();
+    l_m.vertices().remove(_l_v);
+    l_m.faces().add(l_ring);
+    return true;
+}
+
+pm::edge_handle add_layout_edge(Embedding& _em, const pm::vertex_handle& _l_v0, const pm::vertex_handle& _l_v1, const LandmarkEditSettings& _settings)
+{
+    LE_ASSERT(_l_v0.mesh == &_em.layout_mesh());
+    LE_ASSERT(_l_v1.mesh == &_em.layout_mesh());
+    LE_ASSERT(_em.is_complete());
+
+    if (_l_v0 == _l_v1 || edge_between(_l_v0, _l_v1).is_valid()) {
+        return pm::edge_handle::invalid;
+    }
+
+    // Find a face containing both vertices
+    pm::face_handle l_f = pm::face_handle::invalid;
+    std::vector<pm::vertex_handle> l_f_vertices;
+    int i0 = -1;
+    int i1 = -1;
+    for (const auto l_f_candidate : _l_v0.faces()) {
+        if (!l_f_candidate.is_valid()) {
+            continue;
+        }
+        const auto vertices = l_f_candidate.vertices().to_vector();
+        const auto it0 = std::find(vertices.begin(), vertices.end(), _l_v0);
+        const auto it1 = std::find(vertices.begin(), vertices.end(), _l_v1);
+        if (it1 != vertices.end()) {
+            l_f = l_f_candidate;
+            l_f_vertices = vertices;
+            i0 = it0 - vertices.begin();
+            i1 = it1 - vertices.begin();
+            break;
+        }
+    }
+    if (!l_f.is_valid()) {
+        return pm::edge_handle::invalid;
+    }
+
+    // Split the face along v0 -> v1
+    const int n = l_f_vertices.size();
+    std::vector<pm::vertex_handle> l_f0_vertices;
+    std::vector<pm::vertex_handle> l_f1_vertices;
+    for (int i = i0; i != i1; i = (i + 1) % n) {
+        l_f0_vertices.push_back(l_f_vertices[i]);
+    }
+    l_f0_vertices.push_back(_l_v1);
+    for (int i = i1; i != i0; i = (i + 1) % n) {
+        l_f1_vertices.push_back(l_f_vertices[i]);
+    }
+    l_f1_vertices.push_back(_l_v0);
+
+    pm::Mesh& l_m = _em.layout_mesh();
+    l_m.faces().remove(l_f);
+    l_m.faces().add(l_f0_vertices);
+    l_m.faces().add(l_f1_vertices);
+    const auto l_e = edge_between(_l_v0, _l_v1);
+    LE_ASSERT(l_e.is_valid());
+
+    if (!embed_remaining(_em, _settings)) {
+        l_m.edges().remove(l_e);
+        l_m.faces().add(l_f_vertices);
+        return pm::edge_handle::invalid;
+    }
+    return l_e;
+}
+
+bool remove_layout_edge(Embedding& _em, const pm::edge_handle& _l_e)
+{
+    LE_ASSERT(_l_e.mesh == &_em.layout_mesh());
+
+    if (_l_e.is_boundary()) {
+        return false;
+    }
+
+    // Collect the vertices of the merged face: Walk around face A from the end of l_he to its start,
+    // then around face B back to the end of l_he.
+    std::vector<pm::vertex_handle> l_merged;
+    for (const auto l_he : { _l_e.halfedgeA(), _l_e.halfedgeB() }) {
+        for (auto l_he_face = l_he.next(); l_he_face != l_he; l_he_face = l_he_face.next()) {
+            l_merged.push_back(l_he_face.vertex_from());
+        }
+    }
+    if (_l_e.faceA() == _l_e.faceB() || has_duplicates(l_merged)) {
+        return false;
+    }
+
+    if (_em.is_embedded(_l_e)) {
+        _em.unembed_path(_l_e);
+    }
+
+    pm::Mesh& l_m = _em.layout_mesh();
+    l_m.edges().remove(_l_e);
+    l_m.faces().add(l_merged);
+    return true;
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/Greedy.hh>
+
+#include <vector>
+
+namespace LayoutEmbedding {
+
+// Local edits of a complete embedding.
+// Only the affected paths are unembedded and embedded again (see embed_greedy), all other paths are kept.
+// If the affected paths cannot be embedded, the edit is undone and the previous paths are restored.
+//
+// Edits of the layout connectivity modify the layout mesh of the embedding input, which is shared by all embeddings of it.
+// Removed layout elements are not compacted (indices of the remaining ones stay valid).
+// Undoing an edit re-creates the split or merged layout face, which then has a new face handle.
+//
+// Cost: Edits that change the landmarks (move_landmark, add_layout_vertex, remove_layout_vertex) discard the
+// vertex repulsive energy, since it depends on all landmarks. With use_vertex_repulsive_tracing (e.g. the settings
+// of embed_praun), the next path search recomputes it, i.e. solves one harmonic field per landmark on the whole
+// target mesh. Such edits are not proportional to the local change. Failed edits restore the previous energy.
+
+struct LandmarkEditSettings
+{
+    /// Algorithm used to embed the affected paths again, e.g. the settings of the initial greedy embedding.
+    GreedySettings greedy_settings;
+};
+
+/// Unembeds the given layout edges (if embedded) and embeds them again.
+/// Returns false (and restores the previous paths) if they cannot be embedded.
+bool reembed_edges(Embedding& _em, const std::vector<pm::edge_handle>& _l_edges, const LandmarkEditSettings& _settings = LandmarkEditSettings());
+
+/// Matches the layout vertex _l_v to the target vertex _t_v.
+/// Only the paths incident to _l_v and the paths passing through _t_v are re-embedded.
+/// Returns false (and leaves the embedding unchanged) if _t_v is matched to another layout vertex
+/// or the affected paths cannot be embedded.
+bool move_landmark(Embedding& _em, const pm::vertex_handle& _l_v, const pm::vertex_handle& _t_v, const LandmarkEditSettings& _settings = LandmarkEditSettings());
+
+/// Adds a layout vertex inside the layout face _l_f, matched to the target vertex _t_v and connected to all corners of _l_f.
+/// Embeds the new edges. The boundary paths of _l_f are only re-embedded if _t_v lies outside of their patch,
+/// paths passing through _t_v are re-embedded as well.
+/// Returns the new layout vertex, or an invalid handle (undoing the edit) if the edit is not possible.
+pm::vertex_handle add_layout_vertex(Embedding& _em, const pm::face_handle& _l_f, const pm::vertex_handle& _t_v, const LandmarkEditSettings& _settings = LandmarkEditSettings());
+
+/// Removes the layout vertex _l_v and its incident edges, merging the adjacent faces into one.
+/// No paths have to be re-embedded.
+/// Returns false (and leaves the embedding unchanged) for boundary vertices, vertices with valence < 3,
+/// or if the merged face would visit a vertex twice.
+bool remove_layout_vertex(Embedding& _em, const pm::vertex_handle& _l_v);
+
+/// Adds a layout edge between the non-adjacent layout vertices _l_v0 and _l_v1, splitting a face they share, and embeds it.
+/// Returns the new layout edge, or an invalid handle (undoing the edit) if the edit is not possible.
+pm::edge_handle add_layout_edge(Embedding& _em, const pm::vertex_handle& _l_v0, const pm::vertex_handle& _l_v1, const LandmarkEditSettings& _settings = LandmarkEditSettings());
+
+/// Removes the layout edge _l_e, merging its two adjacent faces into one.
+/// No paths have to be re-embedded.
+/// Returns false (and leaves the embedding unchanged) for boundary edges or if the merged face would visit a vertex twice.
+bool remove_layout_edge(Embedding& _em, const pm::edge_handle& _l_e);
+
+}
@@ -0,0 +1,186 @@
+#include "LocalSearch.hh"
+
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <glow-extras/timing/CpuTimer.hh>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace LayoutEmbedding {
+
+namespace {
+
+/// Converts an embedded path (a sequence of target vertices) back into a VirtualPath that can be embedded again.
+VirtualPath to_virtual_path(const std::vector<pm::vertex_handle>& _t_vertices)
+{
+    VirtualPath path;
+    for (const auto t_v : _t_vertices) {
+        path.push_back(VirtualVertex(t_v));
+    }
+    return path;
+}
+
+}
+
+LocalSearchResult improve_embedding(Embedding& _em, const LocalSearchSettings& _settings)
+{
+    glow::timing::CpuTimer timer;
+    ProgressReporter progress(&_settings.progress, "local_search");
+
+    LE_ASSERT(_em.is_complete());
+
+    const pm::Mesh& l_m = _em.layout_mesh();
+    const int l_num_edges = l_m.edges().size();
+
+    LocalSearchResult result;
+    result.initial_cost = _em.total_embedded_path_length();
+    result.cost = result.initial_cost;
+
+    // Edges whose adjacent patches changed since they were last re-traced.
+    // Indexed by edge index, which is not necessarily compact (see LandmarkEditing.hh).
+    std::vector<bool> dirty(l_m.all_edges().size(), false);
+    for (const auto l_e : l_m.edges()) {
+        dirty[l_e.idx.value] = true;
+    }
+
+    while (result.num_rounds < _settings.max_rounds) {
+        if (progress.cancelled()) {
+            result.cancelled = true;
+            break;
+        }
+        if (timer.elapsedSecondsD() > _settings.time_limit) {
+            break;
+        }
+
+        // Longest paths first, since they promise the largest improvements
+        std::vector<std::pair<double, int>> order;
+        for (const auto l_e : l_m.edges()) {
+            if (dirty[l_e.idx.value]) {
+                order.push_back({_em.embedded_path_length(l_e), l_e.idx.value});
+            }
+        }
+        if (order.empty()) {
+            break; // Fixed point
+        }
+        std::sort(order.begin(), order.end(), std::greater<>());
+
+        // Greedily select an independent set: Unembedding an edge merges its two adjacent patches,
+        // so the search regions of edges that share no layout face are disjoint.
+        std::vector<pm::edge_handle> batch;
+        std::vector<bool> l_f_claimed(l_m.all_faces().size(), false);
+        for (const auto& [length, l_ei] : order) {
+            const auto l_e = l_m.edges()[pm::edge_index(l_ei)];
+            const auto l_fA = l_e.faceA();
+            const auto l_fB = l_e.faceB();
+            if ((l_fA.is_valid() && l_f_claimed[l_fA.idx.value]) || (l_fB.is_valid() && l_f_claimed[l_fB.idx.value])) {
+                continue;
+            }
+            if (l_fA.is_valid()) {
+                l_f_claimed[l_fA.idx.value] = true;
+            }
+            if (l_fB.is_valid()) {
+                l_f_claimed[l_fB.idx.value] = true;
+            }
+            batch.push_back(l_e);
+        }
+
+        const int n = batch.size();
+        std::vector<VirtualPath> old_paths(n);
+        std::vector<double> old_lengths(n);
+        for (int i = 0; i < n; ++i) {
+            const auto l_he = batch[i].halfedgeA();
+            old_paths[i] = to_virtual_path(_em.get_embedded_path(l_he));
+            old_lengths[i] = _em.embedded_path_length(l_he);
+            _em.unembed_path(l_he);
+        }
+
+        // The searches only read the embedding
+        std::vector<VirtualPath> new_paths(n);
+        std::vector<std::exception_ptr> exceptions(n);
+        #pragma omp parallel for schedule(dynamic) if(_settings.parallel)
+        for (int i = 0; i < n; ++i) {
+            try {
+                new_paths[i] = _em.find_shortest_path(batch[i].halfedgeA());
+            }
+            catch (...) {
+                exceptions[i] = std::current_exception();
+            }
+        }
+        for (const auto& exception : exceptions) {
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+
+        // Embedding a path only splits target faces within its own search region,
+        // so the other paths of the batch remain valid.
+        int num_improved = 0;
+        for (int i = 0; i < n; ++i) {
+            const auto l_e = batch[i];
+            dirty[l_e.idx.value] = false;
+            ++result.num_retraced;
+
+            const bool improves = !new_paths[i].empty() && (_em.path_length(new_paths[i]) < old_lengths[i] * (1.0 - _settings.min_relative_improvement));
+            if (improves) {
+                _em.embed_path(l_e.halfedgeA(), new_paths[i]);
+                ++num_improved;
+
+                // The patches adjacent to the other edges of both layout faces changed
+                for (const auto l_f : { l_e.faceA(), l_e.faceB() }) {
+                    if (l_f.is_invalid()) {
+                        continue;
+                    }
+                    for (const auto l_e_f : l_f.edges()) {
+                        if (l_e_f != l_e) {
+                            dirty[l_e_f.idx.value] = true;
+                        }
+                    }
+                }
+            }
+            else {
+                _em.embed_path(l_e.halfedgeA(), old_paths[i]);
+            }
+        }
+
+        ++result.num_rounds;
+        result.num_improved += num_improved;
+        if (num_improved > 0) {
+            result.cost = _em.total_embedded_path_length();
+
+            LocalSearchResult::CostEvent event;
+            event.t = timer.elapsedSecondsD();
+            event.cost = result.cost;
+            result.cost_events.push_back(event);
+        }
+
+        if (progress.due()) {
+            ProgressSnapshot snapshot;
+            snapshot.iteration = result.num_rounds;
+            snapshot.num_done = l_num_edges - std::count(dirty.begin(), dirty.end(), true);
+            snapshot.num_total = l_num_edges;
+            snapshot.upper_bound = result.cost;
+            progress.report(snapshot);
+        }
+    }
+
+    LE_ASSERT(_em.is_complete());
+
+    if (progress.verbose()) {
+        std::cout << "Local search: " << result.initial_cost << " -> " << result.cost << " (" << result.num_improved << " of " << result.num_retraced << " re-traced paths improved, " << result.num_rounds << " rounds)." << std::endl;
+    }
+
+    {
+        ProgressSnapshot snapshot;
+        snapshot.iteration = result.num_rounds;
+        snapshot.num_done = l_num_edges - std::count(dirty.begin(), dirty.end(), true);
+        snapshot.num_total = l_num_edges;
+        snapshot.upper_bound = result.cost;
+        progress.report(snapshot, true);
+    }
+
+    return result;
+}
+
+}
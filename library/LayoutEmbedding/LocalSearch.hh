@@ -0,0 +1,57 @@
+#pragma once
+
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/Progress.hh>
+
+#include <limits>
+#include <vector>
+
+namespace LayoutEmbedding {
+
+struct LocalSearchSettings
+{
+    /// Stop after this many seconds (checked between rounds).
+    double time_limit = std::numeric_limits<double>::infinity();
+
+    /// Stop after this many rounds, even if no fixed point has been reached.
+    int max_rounds = std::numeric_limits<int>::max();
+
+    /// A re-traced path only replaces the embedded one if it is shorter by at least this fraction.
+    double min_relative_improvement = 1e-6;
+
+    /// Trace the paths of independent layout edges concurrently.
+    bool parallel = true;
+
+    /// Progress callbacks, cancellation and console output.
+    /// On cancellation, the embedding remains valid and keeps all improvements found so far.
+    ProgressObserver progress;
+};
+
+struct LocalSearchResult
+{
+    double initial_cost = std::numeric_limits<double>::infinity();
+    double cost = std::numeric_limits<double>::infinity();
+
+    int num_rounds = 0;
+    int num_retraced = 0; // Re-traced paths
+    int num_improved = 0; // Re-traced paths that replaced the embedded one
+
+    struct CostEvent
+    {
+        double t;
+        double cost;
+    };
+    std::vector<CostEvent> cost_events; // One per round that improved the embedding
+
+    bool cancelled = false;
+};
+
+/// Iteratively improves a complete embedding:
+/// Each layout edge is unembedded and re-traced as a shortest path in the region bounded by all other paths,
+/// replacing its embedding if the new path is shorter. Edges are processed in order of decreasing path length.
+/// An edge is only revisited once a path on the boundary of its adjacent patches has changed,
+/// so the search stops at a fixed point in which no single path can be shortened.
+/// Within a round, edges that share no layout face are traced in parallel.
+LocalSearchResult improve_embedding(Embedding& _em, const LocalSearchSettings& _settings = LocalSearchSettings());
+
+}
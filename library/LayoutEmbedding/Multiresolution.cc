@@ -0,0 +1,340 @@
+#include "Multiresolution.hh"
+
+#include <LayoutEmbedding/SearchRegion.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <polymesh/algorithms/decimate.hh>
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+namespace LayoutEmbedding {
+
+namespace {
+
+/// Weight of the point quadrics that pin the landmark vertices during decimation.
+constexpr float landmark_quadric_weight = 1000.0f;
+
+/// Decimates a copy of the target mesh of _em into _coarse_input.t_m (see make_layout_by_decimation)
+/// and sets up the layout mesh and matching vertices of _coarse_input accordingly.
+void make_coarse_input(const Embedding& _em, const int _n_vertices, EmbeddingInput& _coarse_input)
+{
+    _coarse_input.l_m.copy_from(_em.layout_mesh());
+    _coarse_input.l_pos = _coarse_input.l_m.vertices().make_attribute<tg::pos3>();
+    _coarse_input.l_pos.copy_from(_em.layout_pos());
+
+    pm::Mesh& c_m = _coarse_input.t_m;
+    c_m.copy_from(_em.target_mesh());
+    _coarse_input.t_pos = c_m.vertices().make_attribute<tg::pos3>();
+    _coarse_input.t_pos.copy_from(_em.target_pos());
+
+    // Remember the original index of every coarse vertex
+    auto c_fine_vertex = c_m.vertices().make_attribute<int>();
+    for (const auto c_v : c_m.vertices()) {
+        c_fine_vertex[c_v] = c_v.idx.value;
+    }
+
+    pm::vertex_attribute<tg::quadric3> c_error(c_m);
+    for (const auto& c_v : c_m.vertices()) {
+        for (const auto& c_f : c_v.faces()) {
+            const auto& p = _coarse_input.t_pos[c_v];
+            const auto& n = pm::face_normal(c_f, _coarse_input.t_pos);
+            c_error[c_v].add_plane(p, n, 0.0);
+        }
+    }
+
+    // A heavily weighted point quadric makes removing a landmark more expensive than any other collapse,
+    // while collapsing neighboring vertices into it stays cheap.
+    for (const auto l_v : _em.layout_mesh().vertices()) {
+        const auto c_v = c_m.vertices()[_em.matching_target_vertex(l_v).idx];
+        const auto& p = _coarse_input.t_pos[c_v];
+        tg::quadric3 point_quadric;
+        point_quadric.add_plane(p, tg::vec3(1, 0, 0), 0.0);
+        point_quadric.add_plane(p, tg::vec3(0, 1, 0), 0.0);
+        point_quadric.add_plane(p, tg::vec3(0, 0, 1), 0.0);
+        c_error[c_v] = c_error[c_v] + point_quadric * landmark_quadric_weight;
+    }
+
+    pm::decimate_down_to(c_m, _coarse_input.t_pos, c_error, _n_vertices);
+    c_m.compactify();
+
+    std::unordered_map<int, pm::vertex_handle> coarse_vertex_of;
+    for (const auto c_v : c_m.vertices()) {
+        coarse_vertex_of[c_fine_vertex[c_v]] = c_v;
+    }
+
+    _coarse_input.l_matching_vertex = _coarse_input.l_m.vertices().make_attribute<pm::vertex_handle>();
+    for (const auto l_v : _coarse_input.l_m.vertices()) {
+        const auto it = coarse_vertex_of.find(_em.matching_target_vertex(l_v).idx.value);
+        if (it == coarse_vertex_of.end()) {
+            LE_ERROR_THROW("Decimation removed a landmark vertex. Try a larger coarse_target_vertices.");
+        }
+        _coarse_input.l_matching_vertex[l_v] = it->second;
+    }
+}
+
+double average_edge_length(const pm::Mesh& _m, const pm::vertex_attribute<tg::pos3>& _pos)
+{
+    double total = 0.0;
+    for (const auto e : _m.edges()) {
+        total += tg::distance(_pos[e.vertexA()], _pos[e.vertexB()]);
+    }
+    return total / std::max(1, (int)_m.edges().size());
+}
+
+/// Layout halfedges embedded at the target vertex of _l_v, in the cyclic order around it
+/// (rotated such that the smallest index comes first).
+std::vector<int> cyclic_order(const Embedding& _em, const pm::vertex_handle& _l_v)
+{
+    std::vector<int> order;
+    for (const auto t_h : _em.matching_target_vertex(_l_v).outgoing_halfedges()) {
+        const auto l_h = _em.matching_layout_halfedge(t_h);
+        if (l_h.is_valid()) {
+            order.push_back(l_h.idx.value);
+        }
+    }
+    if (!order.empty()) {
+        std::rotate(order.begin(), std::min_element(order.begin(), order.end()), order.end());
+    }
+    return order;
+}
+
+/// Returns true if the embedded paths leave every landmark of _em in the same cyclic order as in _coarse_em.
+bool same_cyclic_orders(const Embedding& _em, const Embedding& _coarse_em)
+{
+    for (const auto l_v : _em.layout_mesh().vertices()) {
+        const auto c_l_v = _coarse_em.layout_mesh().vertices()[l_v.idx];
+        if (cyclic_order(_em, l_v) != cyclic_order(_coarse_em, c_l_v)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+enum class SolveStatus
+{
+    Complete,
+    Cancelled,
+    DeadEnd, // Finished without a complete embedding
+};
+
+/// Runs the selected algorithm.
+SolveStatus solve(Embedding& _em, const MultiresolutionSettings& _settings, InsertionSequence& _insertion_sequence)
+{
+    bool cancelled = false;
+    if (_settings.algorithm == MultiresolutionSettings::Algorithm::Greedy) {
+        const auto result = embed_greedy(_em, _settings.greedy_settings);
+        _insertion_sequence = result.insertion_sequence;
+        cancelled = result.cancelled;
+    }
+    else if (_settings.algorithm == MultiresolutionSettings::Algorithm::BranchAndBound) {
+        const auto result = branch_and_bound(_em, _settings.bnb_settings);
+        _insertion_sequence = result.insertion_sequence;
+        cancelled = result.cancelled;
+    }
+    else {
+        LE_ASSERT(false); // Never reached.
+    }
+
+    if (_em.is_complete()) {
+        return SolveStatus::Complete;
+    }
+    return cancelled ? SolveStatus::Cancelled : SolveStatus::DeadEnd;
+}
+
+/// Removes all paths (the target mesh keeps its refinement).
+void unembed_all(Embedding& _em)
+{
+    for (const auto l_e : _em.layout_mesh().edges()) {
+        if (_em.is_embedded(l_e)) {
+            _em.unembed_path(l_e.halfedgeA());
+        }
+    }
+}
+
+}
+
+MultiresolutionResult embed_multiresolution(Embedding& _em, const MultiresolutionSettings& _settings)
+{
+    ProgressReporter progress(&_settings.progress, "multiresolution");
+
+    const pm::Mesh& l_m = _em.layout_mesh();
+    for (const auto l_e : l_m.edges()) {
+        LE_ASSERT(!_em.is_embedded(l_e));
+    }
+
+    MultiresolutionResult result;
+    result.coarse_num_vertices = _em.target_mesh().vertices().size();
+
+    if (_em.target_mesh().vertices().size() <= _settings.coarse_target_vertices) {
+        // Small enough to be embedded directly
+        const auto status = solve(_em, _settings, result.insertion_sequence);
+        if (status != SolveStatus::Complete) {
+            result.cancelled = (status == SolveStatus::Cancelled);
+            result.dead_end = (status == SolveStatus::DeadEnd);
+            if (result.dead_end) {
+                unembed_all(_em);
+                result.insertion_sequence.clear();
+            }
+            return result;
+        }
+        result.coarse_cost = _em.total_embedded_path_length();
+        result.cost = result.coarse_cost;
+        return result;
+    }
+
+    // Solve on the coarse mesh
+    EmbeddingInput coarse_input;
+    make_coarse_input(_em, _settings.coarse_target_vertices, coarse_input);
+    result.coarse_num_vertices = coarse_input.t_m.vertices().size();
+    if (progress.verbose()) {
+        std::cout << "Coarse target mesh: " << result.coarse_num_vertices << " of " << _em.target_mesh().vertices().size() << " vertices." << std::endl;
+    }
+
+    Embedding coarse_em(coarse_input);
+    InsertionSequence coarse_insertion_sequence;
+    const auto coarse_status = solve(coarse_em, _settings, coarse_insertion_sequence);
+    if (coarse_status == SolveStatus::Cancelled) {
+        result.cancelled = true;
+        return result;
+    }
+    if (coarse_status == SolveStatus::DeadEnd) {
+        // Nothing to refine. Only the full-resolution fallback remains.
+        result.coarse_dead_end = true;
+        if (progress.verbose()) {
+            std::cout << "Coarse embedding ran into a dead end." << std::endl;
+        }
+    }
+    else {
+        result.coarse_cost = coarse_em.total_embedded_path_length();
+    }
+
+    // Embed the remaining edges (if the sequence is incomplete) after the others
+    {
+        std::vector<bool> in_sequence(l_m.all_edges().size(), false);
+        for (const auto& l_ei : coarse_insertion_sequence) {
+            in_sequence[l_ei.value] = true;
+        }
+        for (const auto l_e : l_m.edges()) {
+            if (!in_sequence[l_e.idx.value]) {
+                coarse_insertion_sequence.push_back(l_e.idx);
+            }
+        }
+    }
+
+    // Refine: Embed the layout edges into the fine mesh in the coarse insertion order,
+    // each within a corridor around its coarse path.
+    const double coarse_edge_length = average_edge_length(coarse_input.t_m, coarse_input.t_pos);
+    for (int i = 0; i < coarse_insertion_sequence.size() && !result.coarse_dead_end; ++i) {
+        if (progress.cancelled()) {
+            result.cancelled = true;
+            return result;
+        }
+        if (progress.due()) {
+            ProgressSnapshot snapshot;
+            snapshot.iteration = i;
+            snapshot.num_done = i;
+            snapshot.num_total = coarse_insertion_sequence.size();
+            progress.report(snapshot);
+        }
+
+        const auto l_e = l_m.edges()[coarse_insertion_sequence[i]];
+        const auto l_he = l_e.halfedgeA();
+        const auto c_l_he = coarse_em.layout_mesh().halfedges()[l_he.idx];
+
+        const auto t_he_sector_start = _em.get_embeddable_sector(l_he);
+        const auto t_he_sector_end = _em.get_embeddable_sector(l_he.opposite());
+
+        VirtualPath path;
+        if (coarse_em.is_embedded(c_l_he)) {
+            std::vector<tg::pos3> guide;
+            for (const auto c_v : coarse_em.get_embedded_path(c_l_he)) {
+                guide.push_back(coarse_em.target_pos()[c_v]);
+            }
+
+            auto corridor = SearchRegion::tube(guide, _settings.corridor_width * coarse_edge_length);
+            corridor.max_widenings = _settings.max_corridor_widenings;
+
+            int num_widenings = 0;
+            path = _em.find_shortest_path(t_he_sector_start, t_he_sector_end, corridor, Embedding::ShortestPathMetric::Geodesic, &num_widenings);
+            if (num_widenings > 0) {
+                ++result.num_widened_corridors;
+            }
+            if (num_widenings > _settings.max_corridor_widenings) {
+                ++result.num_unrestricted_paths;
+            }
+        }
+        else {
+            // No coarse path to guide the search
+            path = _em.find_shortest_path(t_he_sector_start, t_he_sector_end);
+            ++result.num_unrestricted_paths;
+        }
+        if (path.empty()) {
+            // Replaying the coarse order can run into a dead end on the fine mesh
+            result.refinement_failed = true;
+            if (progress.verbose()) {
+                std::cout << "Refinement: No path found for layout edge " << l_e.idx.value << "." << std::endl;
+            }
+            break;
+        }
+
+        _em.embed_path(l_he, path);
+        result.insertion_sequence.push_back(l_e.idx);
+    }
+
+    // The fine embedding has to be topologically equivalent to the optimized coarse one
+    if (!result.coarse_dead_end && !result.refinement_failed && !same_cyclic_orders(_em, coarse_em)) {
+        result.refinement_failed = true;
+        if (progress.verbose()) {
+            std::cout << "Refinement: The cyclic order of the fine paths differs from the coarse solution." << std::endl;
+        }
+    }
+
+    if (result.coarse_dead_end || result.refinement_failed) {
+        // Remove the fine paths and solve at full resolution, if allowed.
+        unembed_all(_em);
+        result.insertion_sequence.clear();
+        if (!_settings.fall_back_to_full_resolution) {
+            result.dead_end = result.coarse_dead_end;
+            return result;
+        }
+        if (progress.verbose()) {
+            std::cout << "Falling back to embedding at full resolution." << std::endl;
+        }
+        result.full_resolution_fallback = true;
+        const auto status = solve(_em, _settings, result.insertion_sequence);
+        if (status != SolveStatus::Complete) {
+            result.cancelled = (status == SolveStatus::Cancelled);
+            result.dead_end = (status == SolveStatus::DeadEnd);
+            if (result.dead_end) {
+                unembed_all(_em);
+                result.insertion_sequence.clear();
+            }
+            return result;
+        }
+    }
+
+    LE_ASSERT(_em.is_complete());
+    result.cost = _em.total_embedded_path_length();
+
+    if (progress.verbose()) {
+        std::cout << "Multiresolution embedding: coarse cost " << result.coarse_cost << ", fine cost " << result.cost << "." << std::endl;
+        if (result.num_unrestricted_paths > 0) {
+            std::cout << result.num_unrestricted_paths << " paths had to leave their corridor." << std::endl;
+        }
+    }
+
+    {
+        ProgressSnapshot snapshot;
+        snapshot.iteration = coarse_insertion_sequence.size();
+        snapshot.num_done = coarse_insertion_sequence.size();
+        snapshot.num_total = coarse_insertion_sequence.size();
+        snapshot.upper_bound = result.cost;
+        progress.report(snapshot, true);
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <LayoutEmbedding/BranchAndBound.hh>
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/Greedy.hh>
+#include <LayoutEmbedding/InsertionSequence.hh>
+#include <LayoutEmbedding/Progress.hh>
+
+namespace LayoutEmbedding {
+
+struct MultiresolutionSettings
+{
+    /// The target mesh is decimated (keeping all landmark vertices) down to this many vertices.
+    /// Smaller target meshes are embedded directly.
+    int coarse_target_vertices = 20000;
+
+    enum class Algorithm
+    {
+        Greedy,
+        BranchAndBound,
+    };
+    Algorithm algorithm = Algorithm::Greedy;
+    GreedySettings greedy_settings;
+    BranchAndBoundSettings bnb_settings;
+
+    /// Fine paths are traced within this distance of the corresponding coarse path,
+    /// given in multiples of the average edge length of the coarse target mesh.
+    double corridor_width = 3.0;
+
+    /// If no path exists within the corridor, its width is doubled (up to this many times)
+    /// before searching the whole embeddable region (see SearchRegion).
+    int max_corridor_widenings = 3;
+
+    /// If the refinement fails (see MultiresolutionResult::refinement_failed),
+    /// solve the problem directly on the full-resolution target mesh instead.
+    bool fall_back_to_full_resolution = true;
+
+    /// Progress callbacks, cancellation and console output of the refinement phase.
+    /// The coarse solve uses the observer in greedy_settings / bnb_settings.
+    ProgressObserver progress;
+};
+
+struct MultiresolutionResult
+{
+    int coarse_num_vertices = 0;
+    double coarse_cost = std::numeric_limits<double>::infinity();
+    double cost = std::numeric_limits<double>::infinity();
+
+    InsertionSequence insertion_sequence;
+
+    int num_widened_corridors = 0; // Paths that were not found in their initial corridor
+    int num_unrestricted_paths = 0; // Paths that were not found in any corridor (or had no coarse path)
+
+    /// Replaying the coarse solution on the fine mesh ran into a dead end or produced
+    /// a different cyclic order of paths around a landmark. The refined paths were removed.
+    bool refinement_failed = false;
+    bool full_resolution_fallback = false; // The result was computed at full resolution (see fall_back_to_full_resolution)
+
+    bool coarse_dead_end = false; // The algorithm found no complete embedding on the coarse mesh, so nothing was refined.
+
+    /// The algorithm found no complete embedding (at the final resolution). _em is left without paths.
+    /// In contrast to cancellation, running again does not help.
+    bool dead_end = false;
+
+    bool cancelled = false;
+};
+
+/// Coarse-to-fine layout embedding:
+/// Solves the problem on a decimated copy of the target mesh,
+/// then embeds the layout edges into the full-resolution target mesh in the same order,
+/// each restricted to a corridor around its coarse path.
+/// If this fails, _em is either embedded at full resolution or left without paths (see fall_back_to_full_resolution).
+/// A complete result has a finite cost, otherwise refinement_failed (without fallback), dead_end or cancelled is set.
+/// _em must not contain any embedded paths.
+MultiresolutionResult embed_multiresolution(Embedding& _em, const MultiresolutionSettings& _settings = MultiresolutionSettings());
+
+}
@@ -1,7 +1,9 @@
 #include "Parametrization.hh"
 
 #include <LayoutEmbedding/Util/Assert.hh>
-#include <LayoutEmbedding/ExactPredicates.h>
+#include <LayoutEmbedding/Predicates.hh>
+
+#include <atomic>
 
 namespace LayoutEmbedding
 {
@@ -9,34 +11,48 @@ namespace LayoutEmbedding
 namespace
 {
 
-const double* ptr(
-        const tg::dpos2& _p)
-{
-    return &_p.x;
-}
+/// Smaller meshes are checked on a single thread.
+constexpr int min_faces_parallel = 5000;
 
 }
 
 bool injective(
         const VertexParam& _param)
 {
-    exactinit();
+    const pm::Mesh& m = _param.mesh();
+    const int n_faces = m.all_faces().size();
+    std::atomic<bool> flipped = false;
+    std::atomic<bool> non_triangle = false;
 
-    for (auto f : _param.mesh().faces())
+    #pragma omp parallel for schedule(dynamic, 1024) if(n_faces >= min_faces_parallel)
+    for (int i = 0; i < n_faces; ++i)
     {
-        LE_ASSERT_EQ(f.vertices().size(), 3);
-        auto it = f.vertices().begin();
-        const auto a = _param[*it];
-        ++it;
-        const auto b = _param[*it];
-        ++it;
-        const auto c = _param[*it];
-
-        if (orient2d(ptr(a), ptr(b), ptr(c)) <= 0.0)
-            return false;
+        // Skip the remaining faces once a flipped one was found
+        if (flipped.load(std::memory_order_relaxed))
+            continue;
+
+        const auto f = m.faces()[i];
+        if (f.is_removed())
+            continue;
+
+        const auto h = f.any_halfedge();
+        if (h.next().next().next() != h)
+        {
+            non_triangle = true;
+            continue;
+        }
+
+        const auto& a = _param[h.vertex_from()];
+        const auto& b = _param[h.vertex_to()];
+        const auto& c = _param[h.next().vertex_to()];
+
+        if (orient2d_sign(a, b, c) <= 0)
+            flipped.store(true, std::memory_order_relaxed);
     }
 
-    return true;
+    LE_ASSERT(!non_triangle);
+
+    return !flipped;
 }
 
 }
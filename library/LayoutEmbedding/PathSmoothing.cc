@@ -6,6 +6,7 @@
 
 #include <glow-extras/timing/CpuTimer.hh>
 #include <queue>
+#include <unordered_map>
 
 namespace LayoutEmbedding
 {
@@ -97,7 +98,8 @@ namespace
 {
 
 void preprocess_split_edges(
-        Embedding& _em)
+        Embedding& _em,
+        const bool _verbose)
 {
     // Split non-boundary edges with both end vertices on the same path
     int n_splits = 0;
@@ -115,7 +117,7 @@ void preprocess_split_edges(
         }
     }
 
-    if (n_splits > 0)
+    if (n_splits > 0 && _verbose)
         std::cout << "Split " << n_splits << " edges during path smoothing preprocess." << std::endl;
 }
 
@@ -300,13 +302,23 @@ Snake transfer_snake_to_target(
     return res;
 }
 
+/// Parametrization of a flap from a previous iteration, by target vertex index.
+/// Target vertex indices are stable while smoothing (the target mesh is only refined).
+using FlapParam = std::unordered_map<int, tg::dpos2>;
+
+/// Flaps with at least this many vertices are warm-started from their previous parametrization.
+constexpr int min_vertices_iterative = 20000;
+
 /**
  * Parametrize flap and straighten edge.
  */
 bool smooth_path(
         Embedding& _em,
         const pm::halfedge_handle& _l_h,
-        const bool _quad_flap_to_rectangle)
+        const bool _quad_flap_to_rectangle,
+        const bool _verbose,
+        HarmonicSolverCache* _cache,
+        FlapParam* _previous_param)
 {
     // Extract flap region mesh
     pm::Mesh region;
@@ -320,15 +332,78 @@ bool smooth_path(
     VertexParam constraint_pos;
     constrain_flap_boundary(_em, _l_h, v_target_to_region, region, constrained, constraint_pos, _quad_flap_to_rectangle);
 
+    auto region_to_target = [&] (const pm::vertex_handle& _r_v) {
+        return h_region_to_target[_r_v.any_outgoing_halfedge()].vertex_from();
+    };
+
     // Compute harmonic parametrization
-    // Try a few times with successively more uniform weights
     VertexParam region_param;
-    if (!harmonic_parametrization(region_pos, constrained, constraint_pos, region_param, LaplaceWeights::MeanValue, false) || !injective(region_param))
+    auto parametrize = [&] (const HarmonicSettings& _settings) {
+        return harmonic_parametrization(region_pos, constrained, constraint_pos, region_param, _settings) && injective(region_param);
+    };
+
+    // Large flaps that were parametrized in a previous iteration are solved iteratively,
+    // starting from the previous parametrization.
+    bool success = false;
+    if (_previous_param && !_previous_param->empty() && (int)region.vertices().size() >= min_vertices_iterative)
+    {
+        // Vertices that were not part of the previous flap start at the centroid of the boundary
+        tg::dvec2 sum(0.0, 0.0);
+        int n_constrained = 0;
+        for (auto r_v : region.vertices())
+        {
+            if (constrained[r_v])
+            {
+                sum += tg::dvec2(constraint_pos[r_v]);
+                ++n_constrained;
+            }
+        }
+        const tg::dpos2 centroid = tg::dpos2(sum / std::max(n_constrained, 1));
+
+        Eigen::MatrixXd initial_guess(region.vertices().size(), 2);
+        for (auto r_v : region.vertices())
+        {
+            const auto it = _previous_param->find(region_to_target(r_v).idx.value);
+            const auto p = it != _previous_param->end() ? it->second : centroid;
+            initial_guess.row(r_v.idx.value) = Eigen::Vector2d(p.x, p.y);
+        }
+
+        HarmonicSettings harmonic_settings;
+        harmonic_settings.solver = HarmonicSolver::Iterative;
+        harmonic_settings.initial_guess = &initial_guess;
+        success = parametrize(harmonic_settings);
+    }
+
+    // Try a few times with successively more uniform weights
+    if (!success)
     {
-        if (!harmonic_parametrization(region_pos, constrained, constraint_pos, region_param, LaplaceWeights::Uniform, true) || !injective(region_param))
+        HarmonicSettings harmonic_settings;
+        harmonic_settings.cache = _cache;
+        success = parametrize(harmonic_settings);
+        if (!success)
         {
+            harmonic_settings.weights = LaplaceWeights::Uniform;
+            harmonic_settings.fallback_iterative = true;
+            success = parametrize(harmonic_settings);
+        }
+    }
+
+    if (!success)
+    {
+        if (_verbose)
             std::cout << "Path smoothing failed" << std::endl;
-            return false;
+        return false;
+    }
+
+    // Only large flaps are warm-started, smaller ones are not worth recording
+    if (_previous_param)
+    {
+        _previous_param->clear();
+        if ((int)region.vertices().size() >= min_vertices_iterative)
+        {
+            _previous_param->reserve(region.vertices().size());
+            for (auto r_v : region.vertices())
+                (*_previous_param)[region_to_target(r_v).idx.value] = region_param[r_v];
         }
     }
 
@@ -350,37 +425,73 @@ bool smooth_path(
 Embedding smooth_paths(
         const Embedding& _em_orig,
         const int _n_iters,
-        const bool _quad_flap_to_rectangle)
+        const bool _quad_flap_to_rectangle,
+        const ProgressObserver* _progress,
+        HarmonicSolverCache::Stats* _cache_stats)
 {
-    return smooth_paths(_em_orig, _em_orig.layout_mesh().edges().to_vector(), _n_iters, _quad_flap_to_rectangle);
+    return smooth_paths(_em_orig, _em_orig.layout_mesh().edges().to_vector(), _n_iters, _quad_flap_to_rectangle, _progress, _cache_stats);
 }
 
 Embedding smooth_paths(
         const Embedding& _em_orig,
         const std::vector<pm::edge_handle>& _l_edges,
         const int _n_iters,
-        const bool _quad_flap_to_rectangle)
+        const bool _quad_flap_to_rectangle,
+        const ProgressObserver* _progress,
+        HarmonicSolverCache::Stats* _cache_stats)
 {
     glow::timing::CpuTimer timer;
+    ProgressReporter progress(_progress, "smooth_paths");
 
     Embedding em = _em_orig; // copy
 
     // Split non-boundary edges with both end vertices on the same path
-    preprocess_split_edges(em);
+    preprocess_split_edges(em, progress.verbose());
+
+    // Converged flaps are re-solved with identical systems in later iterations
+    HarmonicSolverCache harmonic_cache;
+    std::unordered_map<int, FlapParam> previous_params; // By layout edge index
 
+    const int n_total = _n_iters * (int)_l_edges.size();
+    int n_done = 0;
     for (int iter = 0; iter < _n_iters; ++iter)
     {
         for (auto l_e : _l_edges)
         {
+            // Return the partial result. Each smoothed path leaves a valid embedding.
+            if (progress.cancelled())
+            {
+                if (_cache_stats)
+                    *_cache_stats = harmonic_cache.stats();
+                return em;
+            }
+
             if (!l_e.is_boundary())
-                smooth_path(em, l_e.halfedgeA(), _quad_flap_to_rectangle);
+                smooth_path(em, l_e.halfedgeA(), _quad_flap_to_rectangle, progress.verbose(), &harmonic_cache, &previous_params[l_e.idx.value]);
+
+            ++n_done;
+            if (progress.due())
+            {
+                ProgressSnapshot snapshot;
+                snapshot.iteration = iter;
+                snapshot.num_done = n_done;
+                snapshot.num_total = n_total;
+                progress.report(snapshot);
+            }
         }
     }
 
-    std::cout << "Smoothing paths (" << _n_iters << " iterations) took "
-              << timer.elapsedSecondsD() << " s. "
-              << "Resulting mesh has " << em.target_mesh().vertices().size() << " vertices."
-              << std::endl;
+    if (progress.verbose())
+    {
+        std::cout << "Smoothing paths (" << _n_iters << " iterations) took "
+                  << timer.elapsedSecondsD() << " s. "
+                  << "Resulting mesh has " << em.target_mesh().vertices().size() << " vertices."
+                  << std::endl;
+        std::cout << "Harmonic solver cache: " << 100.0 * harmonic_cache.stats().hit_rate() << " % hits, "
+                  << harmonic_cache.stats().t_saved << " s saved." << std::endl;
+    }
+    if (_cache_stats)
+        *_cache_stats = harmonic_cache.stats();
 
     return em;
 }
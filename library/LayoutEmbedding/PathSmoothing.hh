@@ -1,6 +1,8 @@
 #pragma once
 
 #include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/Harmonic.hh>
+#include <LayoutEmbedding/Progress.hh>
 
 namespace LayoutEmbedding
 {
@@ -17,11 +19,17 @@ Embedding subdivide(
  * embedded paths have been smoothed via straight
  * lines harmonic parametrizations of the two adjacent
  * patches, as described in [Praun2001].
+ * If cancelled via _progress, the partially
+ * smoothed embedding is returned.
+ * If _cache_stats is given, it receives the statistics
+ * of the harmonic solver cache shared by all flaps.
  */
 Embedding smooth_paths(
         const Embedding& _em_orig,
         const int _n_iters = 1,
-        const bool _quad_flap_to_rectangle = true);
+        const bool _quad_flap_to_rectangle = true,
+        const ProgressObserver* _progress = nullptr,
+        HarmonicSolverCache::Stats* _cache_stats = nullptr);
 
 /**
  * Smooth only selected edges
@@ -30,6 +38,8 @@ Embedding smooth_paths(
         const Embedding& _em_orig,
         const std::vector<pm::edge_handle>& _l_edges,
         const int _n_iters = 1,
-        const bool _quad_flap_to_rectangle = true);
+        const bool _quad_flap_to_rectangle = true,
+        const ProgressObserver* _progress = nullptr,
+        HarmonicSolverCache::Stats* _cache_stats = nullptr);
 
 }
@@ -0,0 +1,28 @@
+#include "Predicates.hh"
+
+#include <LayoutEmbedding/ExactPredicates.h>
+
+namespace LayoutEmbedding {
+
+namespace {
+
+struct ExactInit
+{
+    ExactInit() { exactinit(); }
+};
+
+}
+
+void init_exact_predicates()
+{
+    // exactinit() writes global constants, so it must not run concurrently
+    static const ExactInit exact_init;
+}
+
+int exact_orient2d(const tg::dpos2& _a, const tg::dpos2& _b, const tg::dpos2& _c)
+{
+    init_exact_predicates();
+    return sign_orient2d(&_a.x, &_b.x, &_c.x);
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <typed-geometry/tg-lean.hh>
+
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace LayoutEmbedding {
+
+/// Calls exactinit() of ExactPredicates.h. Thread-safe, only the first call has an effect.
+/// Called implicitly by the functions below.
+void init_exact_predicates();
+
+/// Sign (-1, 0, 1) of the exact orient2d(_a, _b, _c).
+int exact_orient2d(const tg::dpos2& _a, const tg::dpos2& _b, const tg::dpos2& _c);
+
+namespace detail {
+
+/// Error bound of the floating-point orientation determinant (ccwerrboundA in [Shewchuk1997]).
+constexpr double orient2d_epsilon = std::numeric_limits<double>::epsilon() / 2.0;
+constexpr double orient2d_error_bound = (3.0 + 16.0 * orient2d_epsilon) * orient2d_epsilon;
+
+}
+
+/// Sign (-1, 0, 1) of the orientation of the triangle (_a, _b, _c), positive if counter-clockwise.
+/// Evaluated in floating point. Only falls back to exact arithmetic if the sign is uncertain.
+inline int orient2d_sign(const tg::dpos2& _a, const tg::dpos2& _b, const tg::dpos2& _c)
+{
+    const double det_left = (_a.x - _c.x) * (_b.y - _c.y);
+    const double det_right = (_a.y - _c.y) * (_b.x - _c.x);
+    const double det = det_left - det_right;
+    if (std::abs(det) > detail::orient2d_error_bound * (std::abs(det_left) + std::abs(det_right)))
+        return (det > 0.0) - (det < 0.0);
+
+    return exact_orient2d(_a, _b, _c);
+}
+
+/// Signs of N orientation tests (_a[i], _b[i], _c[i]), see orient2d_sign.
+/// The filter stage is a branch-free loop over the N tests, which the compiler vectorizes
+/// (e.g. 4 tests per AVX instruction). Only uncertain tests are re-evaluated exactly afterwards.
+template <int N>
+std::array<int, N> orient2d_signs(
+        const std::array<tg::dpos2, N>& _a,
+        const std::array<tg::dpos2, N>& _b,
+        const std::array<tg::dpos2, N>& _c)
+{
+    double det[N];
+    double bound[N];
+    for (int i = 0; i < N; ++i) {
+        const double det_left = (_a[i].x - _c[i].x) * (_b[i].y - _c[i].y);
+        const double det_right = (_a[i].y - _c[i].y) * (_b[i].x - _c[i].x);
+        det[i] = det_left - det_right;
+        bound[i] = detail::orient2d_error_bound * (std::abs(det_left) + std::abs(det_right));
+    }
+
+    std::array<int, N> result;
+    bool uncertain = false;
+    for (int i = 0; i < N; ++i) {
+        result[i] = (det[i] > 0.0) - (det[i] < 0.0);
+        uncertain |= !(std::abs(det[i]) > bound[i]);
+    }
+
+    if (uncertain) {
+        for (int i = 0; i < N; ++i) {
+            if (!(std::abs(det[i]) > bound[i]))
+                result[i] = exact_orient2d(_a[i], _b[i], _c[i]);
+        }
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,43 @@
+#include "Progress.hh"
+
+namespace LayoutEmbedding {
+
+ProgressReporter::ProgressReporter(const ProgressObserver* _observer, const std::string& _algorithm) :
+    observer(_observer),
+    algorithm(_algorithm),
+    start(Clock::now()),
+    last_report(start)
+{
+}
+
+bool ProgressReporter::due() const
+{
+    if (!observer || !observer->callback) {
+        return false;
+    }
+    if (!reported || observer->min_interval <= 0.0) {
+        return true;
+    }
+    const std::chrono::duration<double> elapsed = Clock::now() - last_report;
+    return elapsed.count() >= observer->min_interval;
+}
+
+void ProgressReporter::report(ProgressSnapshot& _snapshot, bool _force)
+{
+    if (!observer || !observer->callback) {
+        return;
+    }
+    if (!_force && !due()) {
+        return;
+    }
+
+    const auto now = Clock::now();
+    _snapshot.algorithm = algorithm;
+    _snapshot.t = std::chrono::duration<double>(now - start).count();
+    observer->callback(_snapshot);
+
+    last_report = now;
+    reported = true;
+}
+
+}
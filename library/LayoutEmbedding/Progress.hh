@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace LayoutEmbedding {
+
+/// Can be cancelled from any thread. Long-running algorithms poll it regularly.
+class CancellationToken
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void cancel() { flag.store(true, std::memory_order_relaxed); }
+    void reset() { flag.store(false, std::memory_order_relaxed); }
+    bool cancelled() const
+    {
+        return flag.load(std::memory_order_relaxed)
+            || (parent && parent->cancelled())
+            || (deadline && Clock::now() >= *deadline);
+    }
+
+    /// Also counts as cancelled once _deadline has passed.
+    /// Set both of these before the token is polled by other threads.
+    void set_deadline(const Clock::time_point& _deadline) { deadline = _deadline; }
+    /// Also counts as cancelled if _parent is cancelled. Optional. Not owned.
+    void set_parent(const CancellationToken* _parent) { parent = _parent; }
+
+private:
+    std::atomic<bool> flag{false};
+    const CancellationToken* parent = nullptr;
+    std::optional<Clock::time_point> deadline;
+};
+
+/// Thrown by algorithms that have no meaningful partial result (e.g. quad meshing) when cancelled.
+struct OperationCancelled : public std::runtime_error
+{
+    explicit OperationCancelled(const std::string& _algorithm) :
+        std::runtime_error(_algorithm + " was cancelled.")
+    {
+    }
+};
+
+struct ProgressSnapshot
+{
+    std::string algorithm; // e.g. "bnb", "greedy", "smooth_paths", "parametrize_patches"
+    double t = 0.0; // Seconds since start of the algorithm
+    int iteration = 0;
+    int num_done = 0; // Work items (e.g. embedded edges, smoothed paths, parametrized patches)
+    int num_total = 0;
+
+    // Only set by branch-and-bound
+    double upper_bound = std::numeric_limits<double>::infinity();
+    double lower_bound = 0.0;
+    int queue_size = 0;
+};
+
+/// Passed to the embedding algorithms to observe and control their progress.
+struct ProgressObserver
+{
+    /// Called with at most one snapshot per min_interval seconds (plus a final one).
+    /// Might be called concurrently if several greedy variants run in parallel (see embed_greedy).
+    std::function<void(const ProgressSnapshot&)> callback;
+    double min_interval = 0.5; // Seconds. Set to <= 0 to receive every snapshot.
+
+    /// Optional. Not owned.
+    const CancellationToken* cancellation_token = nullptr;
+
+    /// Set to false to suppress all console output.
+    bool verbose = true;
+
+    bool cancelled() const { return cancellation_token && cancellation_token->cancelled(); }
+};
+
+/// Rate-limits the snapshots of a single algorithm run.
+class ProgressReporter
+{
+public:
+    ProgressReporter(const ProgressObserver* _observer, const std::string& _algorithm);
+
+    bool verbose() const { return !observer || observer->verbose; }
+    bool cancelled() const { return observer && observer->cancelled(); }
+
+    /// Returns false if nobody is listening. Use this to avoid assembling expensive snapshots.
+    bool due() const;
+
+    /// Fills in algorithm and t, then invokes the callback if due (or if _force is set).
+    void report(ProgressSnapshot& _snapshot, bool _force = false);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const ProgressObserver* observer;
+    std::string algorithm;
+    Clock::time_point start;
+    Clock::time_point last_report;
+    bool reported = false;
+};
+
+}
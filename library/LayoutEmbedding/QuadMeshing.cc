@@ -2,22 +2,47 @@
 
 #include <LayoutEmbedding/Harmonic.hh>
 #include <LayoutEmbedding/Embedding.hh>
-#include <LayoutEmbedding/ExactPredicates.h>
+#include <LayoutEmbedding/Predicates.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
 #include <LayoutEmbedding/Visualization/Visualization.hh>
 
+#include <glow-extras/timing/CpuTimer.hh>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 namespace LayoutEmbedding
 {
 
 namespace
 {
 
+/// Boundary value problem of a single layout face in parametrize_patches.
+struct PatchProblem
+{
+    pm::Mesh m;
+    pm::vertex_attribute<tg::pos3> pos;
+    pm::halfedge_attribute<pm::halfedge_handle> h_patch_to_target;
+    pm::vertex_attribute<bool> constrained;
+    pm::vertex_attribute<tg::dpos2> constraint_value;
+    VertexParam param;
+};
+
+/// The index map from target to patch vertices is local to the patch
+/// instead of an attribute on the (much larger) target mesh.
 void extract_patch(
         const Embedding& _em,
         const pm::face_handle& _l_f,
         pm::Mesh& _patch,
         pm::vertex_attribute<tg::pos3>& _patch_pos,
-        pm::vertex_attribute<pm::vertex_handle>& _v_target_to_patch,
+        std::unordered_map<int, pm::vertex_handle>& _v_target_to_patch,
         pm::halfedge_attribute<pm::halfedge_handle>& _h_patch_to_target)
 {
     // Init result
@@ -25,7 +50,7 @@ void extract_patch(
     _patch_pos = _patch.vertices().make_attribute<tg::pos3>();
 
     // Index maps
-    _v_target_to_patch = _em.target_mesh().vertices().make_attribute<pm::vertex_handle>();
+    _v_target_to_patch.clear();
     _h_patch_to_target = _patch.halfedges().make_attribute<pm::halfedge_handle>();
 
     // Create region mesh
@@ -34,24 +59,24 @@ void extract_patch(
         // Add vertices to result mesh
         for (auto t_v : t_f.vertices())
         {
-            if (_v_target_to_patch[t_v].is_invalid())
+            auto& r_v = _v_target_to_patch[t_v.idx.value];
+            if (r_v.is_invalid())
             {
-                auto r_v = _patch.vertices().add();
+                r_v = _patch.vertices().add();
                 _patch_pos[r_v] = _em.target_pos()[t_v];
-                _v_target_to_patch[t_v] = r_v;
             }
         }
 
         // Add face to result mesh
         _patch.faces().add(t_f.vertices().to_vector([&] (auto t_v) {
-            return _v_target_to_patch[t_v];
+            return _v_target_to_patch.at(t_v.idx.value);
         }));
 
         // Fill halfedge index map
         for (auto t_h : t_f.halfedges())
         {
-            const auto r_v_from = _v_target_to_patch[t_h.vertex_from()];
-            const auto r_v_to = _v_target_to_patch[t_h.vertex_to()];
+            const auto r_v_from = _v_target_to_patch.at(t_h.vertex_from().idx.value);
+            const auto r_v_to = _v_target_to_patch.at(t_h.vertex_to().idx.value);
             const auto r_h = pm::halfedge_from_to(r_v_from, r_v_to);
             LE_ASSERT(r_h.is_valid());
 
@@ -61,6 +86,72 @@ void extract_patch(
     }
 }
 
+/// Extracts the patch of _l_f and constrains its boundary to the rectangle given by the subdivisions.
+void setup_patch_problem(
+        const Embedding& _em,
+        const pm::face_handle& _l_f,
+        const pm::edge_attribute<int>& _l_subdivisions,
+        PatchProblem& _problem)
+{
+    // Extract patch mesh
+    std::unordered_map<int, pm::vertex_handle> v_target_to_patch;
+    extract_patch(_em, _l_f, _problem.m, _problem.pos, v_target_to_patch, _problem.h_patch_to_target);
+
+    // Constrain patch boundary to rectangle
+    _problem.constrained = _problem.m.vertices().make_attribute<bool>(false);
+    _problem.constraint_value = _problem.m.vertices().make_attribute<tg::dpos2>();
+
+    const double width = _l_subdivisions[_l_f.halfedges().first().edge()] + 1.0;
+    const double height = _l_subdivisions[_l_f.halfedges().last().edge()] + 1.0;
+    const std::vector<tg::dpos2> corners = { {0.0, 0.0}, {width, 0.0}, {width, height}, {0.0, height} };
+    int corner_idx = 0;
+    for (auto l_h : _l_f.halfedges())
+    {
+        const double length_total = _em.embedded_path_length(l_h);
+        double length_acc = 0.0;
+        const auto t_path_vertices = _em.get_embedded_path(l_h);
+        for (int i = 0; i < t_path_vertices.size() - 1; ++i)
+        {
+            const auto t_vi = t_path_vertices[i];
+            const auto t_vj = t_path_vertices[i+1];
+            const double lambda_i = length_acc / length_total;
+            length_acc += tg::length(_em.target_pos()[t_vi] - _em.target_pos()[t_vj]);
+
+            const auto p_vi = v_target_to_patch.at(t_vi.idx.value);
+            _problem.constrained[p_vi] = true;
+            _problem.constraint_value[p_vi] = (1.0 - lambda_i) * corners[corner_idx] + lambda_i * corners[(corner_idx + 1) % 4];
+        }
+
+        ++corner_idx;
+    }
+}
+
+/// Computes the Tutte embedding of the patch.
+/// Only touches _problem and _cache, so distinct patches can be solved concurrently.
+void solve_patch_problem(
+        PatchProblem& _problem,
+        HarmonicSolverCache& _cache)
+{
+    // Try a few times with successively more uniform weights
+    HarmonicSettings harmonic_settings;
+    harmonic_settings.cache = &_cache;
+    if (!harmonic_parametrization(_problem.pos, _problem.constrained, _problem.constraint_value, _problem.param, harmonic_settings))
+    {
+        harmonic_settings.weights = LaplaceWeights::Uniform;
+        harmonic_settings.fallback_iterative = true;
+        if (!harmonic_parametrization(_problem.pos, _problem.constrained, _problem.constraint_value, _problem.param, harmonic_settings))
+        {
+            LE_ERROR_THROW("Harmonic parametrization failed.");
+        }
+    }
+
+    for (auto v : _problem.m.vertices())
+    {
+        LE_ASSERT(std::isfinite(_problem.param[v].x));
+        LE_ASSERT(std::isfinite(_problem.param[v].y));
+    }
+}
+
 }
 
 pm::edge_attribute<int> choose_loop_subdivisions(
@@ -119,9 +210,12 @@ pm::edge_attribute<int> choose_loop_subdivisions(
 
 HalfedgeParam parametrize_patches(
         const Embedding& _em,
-        const pm::edge_attribute<int>& _l_subdivisions)
+        const pm::edge_attribute<int>& _l_subdivisions,
+        const ProgressObserver* _progress,
+        HarmonicSolverCache::Stats* _cache_stats)
 {
     LE_ASSERT(_em.is_complete());
+    ProgressReporter progress(_progress, "parametrize_patches");
     auto param = _em.target_mesh().halfedges().make_attribute<tg::dpos2>();
 
     // Ensure that _l_subdivisions are loop-wise consistent
@@ -132,69 +226,94 @@ HalfedgeParam parametrize_patches(
         LE_ASSERT_EQ(_l_subdivisions[l_e], _l_subdivisions[l_e_opp]);
     }
 
+    std::vector<std::unique_ptr<PatchProblem>> problems;
+
+    // Extract patches. Not parallel, since get_patch creates attributes on the target mesh.
+    glow::timing::CpuTimer timer_extract;
     for (auto l_f : _em.layout_mesh().faces())
     {
         LE_ASSERT_EQ(l_f.vertices().size(), 4);
 
-        // Extract patch mesh
-        pm::Mesh p_m;
-        pm::vertex_attribute<tg::pos3> p_pos;
-        pm::vertex_attribute<pm::vertex_handle> v_target_to_patch;
-        pm::halfedge_attribute<pm::halfedge_handle> h_patch_to_target;
-        extract_patch(_em, l_f, p_m, p_pos, v_target_to_patch, h_patch_to_target);
-
-        // Constrain patch boundary to rectangle
-        auto p_constrained = p_m.vertices().make_attribute<bool>(false);
-        auto p_constraint_value = p_m.vertices().make_attribute<tg::dpos2>();
-
-        const double width = _l_subdivisions[l_f.halfedges().first().edge()] + 1.0;
-        const double height = _l_subdivisions[l_f.halfedges().last().edge()] + 1.0;
-        const std::vector<tg::dpos2> corners = { {0.0, 0.0}, {width, 0.0}, {width, height}, {0.0, height} };
-        int corner_idx = 0;
-        for (auto l_h : l_f.halfedges())
-        {
-            const double length_total = _em.embedded_path_length(l_h);
-            double length_acc = 0.0;
-            const auto t_path_vertices = _em.get_embedded_path(l_h);
-            for (int i = 0; i < t_path_vertices.size() - 1; ++i)
-            {
-                const auto t_vi = t_path_vertices[i];
-                const auto t_vj = t_path_vertices[i+1];
-                const double lambda_i = length_acc / length_total;
-                length_acc += tg::length(_em.target_pos()[t_vi] - _em.target_pos()[t_vj]);
-
-                const auto p_vi = v_target_to_patch[t_vi];
-                p_constrained[p_vi] = true;
-                p_constraint_value[p_vi] = (1.0 - lambda_i) * corners[corner_idx] + lambda_i * corners[(corner_idx + 1) % 4];
-            }
+        if (progress.cancelled())
+            throw OperationCancelled("parametrize_patches");
 
-            ++corner_idx;
-        }
+        problems.push_back(std::make_unique<PatchProblem>());
+        setup_patch_problem(_em, l_f, _l_subdivisions, *problems.back());
+    }
+    const int n = problems.size();
+    const double t_extract = timer_extract.elapsedSecondsD();
+
+    // Solve patches in parallel. Each thread has its own solver cache,
+    // so patches with equal connectivity (e.g. after subdivision) share their symbolic analysis.
+    glow::timing::CpuTimer timer_solve;
+    std::vector<HarmonicSolverCache> harmonic_caches(omp_get_max_threads());
+    std::vector<std::exception_ptr> exceptions(n);
+    std::atomic<bool> cancelled = false;
+    std::mutex mutex; // Guards progress and n_done
+    int n_done = 0;
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < n; ++i)
+    {
+        if (cancelled)
+            continue;
 
-        // Compute Tutte embedding
-        // Try a few times with successively more uniform weights
-        VertexParam p_param;
-        if (!harmonic_parametrization(p_pos, p_constrained, p_constraint_value, p_param, LaplaceWeights::MeanValue, false))
+        try
         {
-            if (!harmonic_parametrization(p_pos, p_constrained, p_constraint_value, p_param, LaplaceWeights::Uniform, true))
-            {
-                LE_ERROR_THROW("Harmonic parametrization failed.");
-            }
+            solve_patch_problem(*problems[i], harmonic_caches[omp_get_thread_num()]);
+        }
+        catch (...)
+        {
+            exceptions[i] = std::current_exception();
         }
 
-        for (auto v : p_m.vertices())
+        std::lock_guard<std::mutex> lock(mutex);
+        ++n_done;
+        if (progress.cancelled())
+            cancelled = true;
+        if (progress.due())
         {
-            LE_ASSERT(std::isfinite(p_param[v].x));
-            LE_ASSERT(std::isfinite(p_param[v].y));
+            ProgressSnapshot snapshot;
+            snapshot.num_done = n_done;
+            snapshot.num_total = n;
+            progress.report(snapshot);
         }
+    }
+    for (const auto& exception : exceptions)
+    {
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+    if (cancelled)
+        throw OperationCancelled("parametrize_patches");
+    const double t_solve = timer_solve.elapsedSecondsD();
 
-        // Transfer parametrization to target mesh
-        for (auto p_h : p_m.halfedges())
+    // Transfer parametrizations to target mesh
+    glow::timing::CpuTimer timer_transfer;
+    for (const auto& problem : problems)
+    {
+        for (auto p_h : problem->m.halfedges())
         {
             if (!p_h.is_boundary())
-                param[h_patch_to_target[p_h]] = p_param[p_h.vertex_to()];
+                param[problem->h_patch_to_target[p_h]] = problem->param[p_h.vertex_to()];
         }
     }
+    const double t_transfer = timer_transfer.elapsedSecondsD();
+
+    HarmonicSolverCache::Stats stats;
+    for (const auto& cache : harmonic_caches)
+        stats += cache.stats();
+    if (_cache_stats)
+        *_cache_stats = stats;
+
+    if (progress.verbose())
+    {
+        std::cout << "Parametrized " << n << " patches: "
+                  << t_extract << " s extraction, "
+                  << t_solve << " s solve, "
+                  << t_transfer << " s transfer." << std::endl;
+        std::cout << "Harmonic solver cache: " << 100.0 * stats.hit_rate() << " % hits, "
+                  << stats.t_saved << " s saved." << std::endl;
+    }
 
     return param;
 }
@@ -233,12 +352,6 @@ int count_subdiv(
         LE_ERROR_THROW("");
 }
 
-const double* ptr(
-        const tg::dpos2& _p)
-{
-    return &_p.x;
-}
-
 bool in_triangle_inclusive(
         const tg::dpos2& _p,
         tg::dpos2 _a, tg::dpos2 _b, tg::dpos2 _c,
@@ -253,9 +366,8 @@ bool in_triangle_inclusive(
         _c = M * _c;
     }
 
-    return orient2d(ptr(_p), ptr(_a), ptr(_b)) >= 0 &&
-           orient2d(ptr(_p), ptr(_b), ptr(_c)) >= 0 &&
-           orient2d(ptr(_p), ptr(_c), ptr(_a)) >= 0;
+    const auto signs = orient2d_signs<3>({ _p, _p, _p }, { _a, _b, _c }, { _b, _c, _a });
+    return signs[0] >= 0 && signs[1] >= 0 && signs[2] >= 0;
 }
 
 std::pair<double, double> compute_bary(
@@ -280,40 +392,159 @@ std::pair<double, double> compute_bary(
     return std::make_pair(alpha, beta);
 }
 
-tg::pos3 point_on_surface(
-        const tg::dpos2& _p,
-        const std::vector<pm::face_handle> _t_patch,
-        const pm::vertex_attribute<tg::pos3> _pos,
-        const HalfedgeParam& _param)
+// To fix numerical issues at the patch boundary, point_on_surface tries the lookup
+// a few times while slowly growing each individual triangle.
+constexpr int point_lookup_attempts = 3;
+constexpr double point_lookup_eps = 1e-6;
+
+/// Uniform grid over the parameter-space triangles of a patch, for point location.
+/// Each cell lists the triangles whose bounding box (enlarged to cover the growth
+/// in point_on_surface) overlaps the cell, in patch order.
+class PatchTriangleGrid
 {
-    // To fix numerical issues at the patch boundary,
-    // try the lookup a few times while slowly growing each individual triangle.
-    const int n_attempts = 3;
-    double scale = 1.0;
-    const double eps = 1e-6;
-    for (int i = 0; i < n_attempts; ++i)
+public:
+    struct Triangle
+    {
+        pm::halfedge_handle ha; // pointing to vertex a
+        tg::dpos2 a;
+        tg::dpos2 b;
+        tg::dpos2 c;
+    };
+
+    PatchTriangleGrid(
+            const std::vector<pm::face_handle>& _t_patch,
+            const HalfedgeParam& _param)
     {
+        LE_ASSERT(!_t_patch.empty());
+        triangles.reserve(_t_patch.size());
         for (auto t_f : _t_patch)
         {
             LE_ASSERT_EQ(t_f.halfedges().size(), 3);
-            const auto ha = t_f.halfedges().first(); // pointing to vertex a
-            const auto hb = ha.next(); // pointing to vertex b
-            const auto hc = hb.next(); // pointing to vertex c
+            const auto ha = t_f.halfedges().first();
+            const auto hb = ha.next();
+            const auto hc = hb.next();
+            triangles.push_back({ ha, _param[ha], _param[hb], _param[hc] });
+        }
+
+        // A triangle scaled about its centroid moves each corner by at most (scale - 1) * (width + height)
+        const double max_scale = std::pow(1.0 + point_lookup_eps, point_lookup_attempts - 1);
+        std::vector<tg::dpos2> box_min(triangles.size());
+        std::vector<tg::dpos2> box_max(triangles.size());
+        tg::dpos2 grid_min = { std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity() };
+        tg::dpos2 grid_max = { -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+        for (int i = 0; i < triangles.size(); ++i)
+        {
+            const auto& t = triangles[i];
+            box_min[i] = { std::min({ t.a.x, t.b.x, t.c.x }), std::min({ t.a.y, t.b.y, t.c.y }) };
+            box_max[i] = { std::max({ t.a.x, t.b.x, t.c.x }), std::max({ t.a.y, t.b.y, t.c.y }) };
+            const double margin = (max_scale - 1.0) * ((box_max[i].x - box_min[i].x) + (box_max[i].y - box_min[i].y));
+            box_min[i] -= tg::dvec2(margin, margin);
+            box_max[i] += tg::dvec2(margin, margin);
+
+            grid_min = { std::min(grid_min.x, box_min[i].x), std::min(grid_min.y, box_min[i].y) };
+            grid_max = { std::max(grid_max.x, box_max[i].x), std::max(grid_max.y, box_max[i].y) };
+        }
+
+        // About one triangle per cell
+        origin = grid_min;
+        const double width = grid_max.x - grid_min.x;
+        const double height = grid_max.y - grid_min.y;
+        const double n = triangles.size();
+        n_x = (width > 0.0 && height > 0.0) ? std::clamp((int)std::round(std::sqrt(n * width / height)), 1, max_cells_per_axis) : 1;
+        n_y = (width > 0.0 && height > 0.0) ? std::clamp((int)std::round(std::sqrt(n * height / width)), 1, max_cells_per_axis) : 1;
+        inv_cell_size.x = width > 0.0 ? n_x / width : 0.0;
+        inv_cell_size.y = height > 0.0 ? n_y / height : 0.0;
+
+        // Compressed cell lists: count, then fill in patch order
+        cell_start.assign(n_x * n_y + 1, 0);
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            std::vector<int> cell_fill;
+            if (pass == 1)
+            {
+                for (int c = 0; c < n_x * n_y; ++c)
+                    cell_start[c + 1] += cell_start[c];
+                cell_triangles.resize(cell_start.back());
+                cell_fill.assign(cell_start.begin(), cell_start.end() - 1);
+            }
+
+            for (int i = 0; i < triangles.size(); ++i)
+            {
+                const int x_min = cell_x(box_min[i].x);
+                const int x_max = cell_x(box_max[i].x);
+                const int y_min = cell_y(box_min[i].y);
+                const int y_max = cell_y(box_max[i].y);
+                for (int y = y_min; y <= y_max; ++y)
+                {
+                    for (int x = x_min; x <= x_max; ++x)
+                    {
+                        const int c = y * n_x + x;
+                        if (pass == 0)
+                            ++cell_start[c + 1];
+                        else
+                            cell_triangles[cell_fill[c]++] = i;
+                    }
+                }
+            }
+        }
+    }
+
+    const Triangle& triangle(const int _i) const { return triangles[_i]; }
+
+    /// Indices of all triangles that might contain _p (also if grown), in patch order.
+    /// Points outside of the grid are mapped to the closest cell.
+    std::pair<const int*, const int*> candidates(const tg::dpos2& _p) const
+    {
+        const int c = cell_y(_p.y) * n_x + cell_x(_p.x);
+        return { cell_triangles.data() + cell_start[c], cell_triangles.data() + cell_start[c + 1] };
+    }
+
+private:
+    static constexpr int max_cells_per_axis = 4096;
+
+    int cell_x(const double _x) const { return std::clamp((int)std::floor((_x - origin.x) * inv_cell_size.x), 0, n_x - 1); }
+    int cell_y(const double _y) const { return std::clamp((int)std::floor((_y - origin.y) * inv_cell_size.y), 0, n_y - 1); }
+
+    std::vector<Triangle> triangles;
 
-            if (in_triangle_inclusive(_p, _param[ha], _param[hb], _param[hc], scale))
+    tg::dpos2 origin;
+    tg::dvec2 inv_cell_size;
+    int n_x = 1;
+    int n_y = 1;
+    std::vector<int> cell_start; // Per cell, offset into cell_triangles. One extra element at the end.
+    std::vector<int> cell_triangles;
+};
+
+tg::pos3 point_on_surface(
+        const tg::dpos2& _p,
+        const PatchTriangleGrid& _grid,
+        const pm::vertex_attribute<tg::pos3>& _pos)
+{
+    // Only the triangles in the grid cell of _p can contain it.
+    // They are tested in patch order, so the result is the same as for a scan over the whole patch.
+    const auto [begin, end] = _grid.candidates(_p);
+    double scale = 1.0;
+    for (int i = 0; i < point_lookup_attempts; ++i)
+    {
+        for (auto it = begin; it != end; ++it)
+        {
+            const auto& t = _grid.triangle(*it);
+            if (in_triangle_inclusive(_p, t.a, t.b, t.c, scale))
             {
-                auto [alpha, beta] = compute_bary(_p, _param[ha], _param[hb], _param[hc]);
+                auto [alpha, beta] = compute_bary(_p, t.a, t.b, t.c);
                 if (!std::isfinite(alpha) || !std::isfinite(beta))
                 {
                     alpha = 1.0 / 3.0;
                     beta = 1.0 / 3.0;
 //                    std::cout << "Computing barycentric coordinates failed due to degenerate triangle." << std::endl;
                 }
-                return alpha * _pos[ha.vertex_to()] + beta * _pos[hb.vertex_to()] + (1.0 - alpha - beta) * _pos[hc.vertex_to()];
+                const auto hb = t.ha.next();
+                const auto hc = hb.next();
+                return alpha * _pos[t.ha.vertex_to()] + beta * _pos[hb.vertex_to()] + (1.0 - alpha - beta) * _pos[hc.vertex_to()];
             }
         }
 
-        scale *= 1.0 + eps;
+        scale *= 1.0 + point_lookup_eps;
     }
 
     LE_ERROR_THROW("Triangle lookup failed");
@@ -325,9 +556,11 @@ pm::vertex_attribute<tg::pos3> extract_quad_mesh(
         const Embedding& _em,
         const HalfedgeParam& _param,
         pm::Mesh& _q,
-        pm::face_attribute<pm::face_handle>& _q_matching_layout_face)
+        pm::face_attribute<pm::face_handle>& _q_matching_layout_face,
+        const ProgressObserver* _progress)
 {
-    exactinit();
+    ProgressReporter progress(_progress, "extract_quad_mesh");
+    int n_done = 0;
 
     _q.clear();
     auto q_pos = _q.vertices().make_attribute<tg::pos3>();
@@ -340,6 +573,18 @@ pm::vertex_attribute<tg::pos3> extract_quad_mesh(
 
     for (auto l_f : _em.layout_mesh().faces())
     {
+        if (progress.cancelled())
+            throw OperationCancelled("extract_quad_mesh");
+
+        ++n_done;
+        if (progress.due())
+        {
+            ProgressSnapshot snapshot;
+            snapshot.num_done = n_done - 1;
+            snapshot.num_total = _em.layout_mesh().faces().size();
+            progress.report(snapshot);
+        }
+
         // Determine patch dimensions
         const auto l_h_u = l_f.halfedges().first(); // u direction
         const auto l_h_v = l_h_u.next();
@@ -351,8 +596,7 @@ pm::vertex_attribute<tg::pos3> extract_quad_mesh(
         std::vector<std::vector<pm::vertex_handle>> fv_cache(n_u, std::vector<pm::vertex_handle>(n_v));
 
         // Get patch target triangles
-        const auto t_patch = _em.get_patch(l_f);
-        LE_ASSERT(!t_patch.empty());
+        const PatchTriangleGrid t_patch_grid(_em.get_patch(l_f), _param);
 
         // Enumerate patch vertices
         for (int u = 0; u < n_u; ++u)
@@ -447,7 +691,7 @@ pm::vertex_attribute<tg::pos3> extract_quad_mesh(
 
                 // Compute position
                 const auto p_param = tg::dpos2((double)u, (double)v);
-                q_pos[q_v] = point_on_surface(p_param, t_patch, _em.target_pos(), _param);
+                q_pos[q_v] = point_on_surface(p_param, t_patch_grid, _em.target_pos());
 
                 // Add vertex to cache
                 fv_cache[u][v] = q_v;
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <LayoutEmbedding/Harmonic.hh>
 #include <LayoutEmbedding/Parametrization.hh>
+#include <LayoutEmbedding/Progress.hh>
 
 namespace LayoutEmbedding
 {
@@ -16,15 +18,22 @@ pm::edge_attribute<int> choose_loop_subdivisions(
 
 /// Takes an embedded quad layout and a valid number of subdivisions
 /// per edge. Returns an integer-grid map.
+/// The patches are parametrized in parallel.
+/// If _cache_stats is given, it receives the statistics of the harmonic solver caches (summed over all threads).
+/// Throws OperationCancelled if cancelled via _progress.
 HalfedgeParam parametrize_patches(
         const Embedding& _em,
-        const pm::edge_attribute<int>& _l_subdivisions);
+        const pm::edge_attribute<int>& _l_subdivisions,
+        const ProgressObserver* _progress = nullptr,
+        HarmonicSolverCache::Stats* _cache_stats = nullptr);
 
 /// Takes an integer-grid map and extracts a quad mesh.
+/// Throws OperationCancelled if cancelled via _progress.
 pm::vertex_attribute<tg::pos3> extract_quad_mesh(
         const Embedding& _em,
         const HalfedgeParam& _param,
         pm::Mesh& _q,
-        pm::face_attribute<pm::face_handle>& _q_matching_layout_face);
+        pm::face_attribute<pm::face_handle>& _q_matching_layout_face,
+        const ProgressObserver* _progress = nullptr);
 
 }
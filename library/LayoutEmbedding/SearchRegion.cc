@@ -0,0 +1,218 @@
+#include "SearchRegion.hh"
+
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace LayoutEmbedding {
+
+struct SearchRegion::SegmentGrid
+{
+    tg::pos3 origin;
+    double cell_size = 1.0;
+    int num_cells[3] = {1, 1, 1};
+
+    /// Segment i connects guide points i and i + 1. Each cell lists all segments within radius of it.
+    std::unordered_map<std::int64_t, std::vector<int>> cells;
+
+    std::int64_t cell_key(int _x, int _y, int _z) const
+    {
+        return ((std::int64_t)_x * num_cells[1] + _y) * num_cells[2] + _z;
+    }
+
+    /// Cell of _p, or false if _p lies outside of the grid.
+    bool cell(const tg::pos3& _p, int (&_c)[3]) const
+    {
+        for (int i = 0; i < 3; ++i) {
+            _c[i] = (int)std::floor((_p[i] - origin[i]) / cell_size);
+            if (_c[i] < 0 || _c[i] >= num_cells[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+void SearchRegion::build_segment_grid()
+{
+    LE_ASSERT(type == Type::Tube);
+    if (guide->size() < 2) {
+        segment_grid.reset();
+        return;
+    }
+
+    // Bounding box of the tube
+    tg::pos3 min = guide->front();
+    tg::pos3 max = guide->front();
+    for (const auto& p : *guide) {
+        for (int i = 0; i < 3; ++i) {
+            min[i] = std::min(min[i], p[i]);
+            max[i] = std::max(max[i], p[i]);
+        }
+    }
+    const float r = radius;
+    min -= tg::vec3(r, r, r);
+    max += tg::vec3(r, r, r);
+
+    // Cells are at least as large as the radius (so each piece of a segment touches few cells),
+    // and at most 256 cells per axis.
+    auto grid = std::make_shared<SegmentGrid>();
+    const double extent = std::max({ max.x - min.x, max.y - min.y, max.z - min.z, 1e-12f });
+    grid->origin = min;
+    grid->cell_size = std::max(radius, extent / 256.0);
+    for (int i = 0; i < 3; ++i) {
+        grid->num_cells[i] = std::max(1, (int)std::ceil((max[i] - min[i]) / grid->cell_size));
+    }
+
+    auto add_box = [&](const tg::pos3& _a, const tg::pos3& _b, int _segment) {
+        int c_min[3], c_max[3];
+        for (int i = 0; i < 3; ++i) {
+            c_min[i] = std::clamp((int)std::floor((std::min(_a[i], _b[i]) - r - min[i]) / grid->cell_size), 0, grid->num_cells[i] - 1);
+            c_max[i] = std::clamp((int)std::floor((std::max(_a[i], _b[i]) + r - min[i]) / grid->cell_size), 0, grid->num_cells[i] - 1);
+        }
+        for (int x = c_min[0]; x <= c_max[0]; ++x) {
+            for (int y = c_min[1]; y <= c_max[1]; ++y) {
+                for (int z = c_min[2]; z <= c_max[2]; ++z) {
+                    auto& segments = grid->cells[grid->cell_key(x, y, z)];
+                    if (segments.empty() || segments.back() != _segment) {
+                        segments.push_back(_segment);
+                    }
+                }
+            }
+        }
+    };
+
+    // Long segments are split into pieces of at most one cell, so diagonal segments do not fill their whole bounding box.
+    for (int i = 0; i + 1 < (int)guide->size(); ++i) {
+        const auto& a = (*guide)[i];
+        const auto& b = (*guide)[i + 1];
+        const int num_pieces = std::max(1, (int)std::ceil(tg::distance(a, b) / grid->cell_size));
+        for (int j = 0; j < num_pieces; ++j) {
+            add_box(tg::mix(a, b, (float)j / num_pieces), tg::mix(a, b, (float)(j + 1) / num_pieces), i);
+        }
+    }
+
+    segment_grid = grid;
+}
+
+SearchRegion SearchRegion::faces(const std::vector<pm::face_handle>& _t_faces)
+{
+    auto t_face_ids = std::make_shared<std::unordered_set<int>>();
+    for (const auto& t_f : _t_faces) {
+        t_face_ids->insert(t_f.idx.value);
+    }
+
+    SearchRegion region;
+    region.type = Type::Faces;
+    region.t_faces = t_face_ids;
+    return region;
+}
+
+SearchRegion SearchRegion::tube(const std::vector<tg::pos3>& _guide, double _radius)
+{
+    LE_ASSERT(!_guide.empty());
+    LE_ASSERT_GEQ(_radius, 0.0);
+
+    SearchRegion region;
+    region.type = Type::Tube;
+    region.guide = std::make_shared<std::vector<tg::pos3>>(_guide);
+    region.radius = _radius;
+    region.build_segment_grid();
+    return region;
+}
+
+SearchRegion SearchRegion::box(const tg::aabb3& _box)
+{
+    SearchRegion region;
+    region.type = Type::Box;
+    region.bounds = _box;
+    return region;
+}
+
+bool SearchRegion::contains(const Embedding& _em, const VirtualVertex& _vv) const
+{
+    const pm::Mesh& t_m = _em.target_mesh();
+
+    if (type == Type::Faces) {
+        if (is_real_vertex(_vv)) {
+            for (const auto t_f : real_vertex(_vv, t_m).faces()) {
+                if (t_f.is_valid() && t_faces->count(t_f.idx.value)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        else {
+            const auto t_e = real_edge(_vv, t_m);
+            for (const auto t_f : { t_e.faceA(), t_e.faceB() }) {
+                if (t_f.is_valid() && t_faces->count(t_f.idx.value)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+    else if (type == Type::Tube) {
+        const auto p = _em.element_pos(_vv);
+        if (guide->size() == 1) {
+            return tg::distance(p, guide->front()) <= radius;
+        }
+        int c[3];
+        if (!segment_grid->cell(p, c)) {
+            return false;
+        }
+        const auto it = segment_grid->cells.find(segment_grid->cell_key(c[0], c[1], c[2]));
+        if (it == segment_grid->cells.end()) {
+            return false;
+        }
+        for (const int i : it->second) {
+            if (tg::distance(p, tg::segment3((*guide)[i], (*guide)[i + 1])) <= radius) {
+                return true;
+            }
+        }
+        return false;
+    }
+    else if (type == Type::Box) {
+        return tg::contains(bounds, _em.element_pos(_vv));
+    }
+    else {
+        LE_ASSERT(false); // Never reached.
+        return false;
+    }
+}
+
+SearchRegion SearchRegion::widened(const Embedding& _em) const
+{
+    SearchRegion region = *this;
+    if (type == Type::Faces) {
+        const pm::Mesh& t_m = _em.target_mesh();
+        auto t_face_ids = std::make_shared<std::unordered_set<int>>(*t_faces);
+        for (const int t_fi : *t_faces) {
+            for (const auto t_v : t_m.faces()[pm::face_index(t_fi)].vertices()) {
+                for (const auto t_f : t_v.faces()) {
+                    if (t_f.is_valid()) {
+                        t_face_ids->insert(t_f.idx.value);
+                    }
+                }
+            }
+        }
+        region.t_faces = t_face_ids;
+    }
+    else if (type == Type::Tube) {
+        region.radius *= widening_factor;
+        region.build_segment_grid();
+    }
+    else if (type == Type::Box) {
+        const auto half_extent = (bounds.max - bounds.min) * 0.5f;
+        const auto center = bounds.min + half_extent;
+        const float factor = widening_factor;
+        region.bounds = tg::aabb3(center - half_extent * factor, center + half_extent * factor);
+    }
+    return region;
+}
+
+}
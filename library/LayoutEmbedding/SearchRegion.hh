@@ -0,0 +1,60 @@
+#pragma once
+
+#include <LayoutEmbedding/VirtualVertex.hh>
+
+#include <polymesh/pm.hh>
+#include <typed-geometry/tg.hh>
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace LayoutEmbedding {
+
+class Embedding;
+
+/// Restricts Embedding::find_shortest_path to a part of the target mesh.
+/// Restricted searches only store data for the elements they visit.
+class SearchRegion
+{
+public:
+    /// Elements incident to one of the given target faces.
+    static SearchRegion faces(const std::vector<pm::face_handle>& _t_faces);
+
+    /// Elements within distance _radius of the polyline _guide (e.g. a coarse or previous path).
+    static SearchRegion tube(const std::vector<tg::pos3>& _guide, double _radius);
+
+    /// Elements inside the axis-aligned box _box.
+    static SearchRegion box(const tg::aabb3& _box);
+
+    bool contains(const Embedding& _em, const VirtualVertex& _vv) const;
+
+    /// Faces: adds one ring of neighboring faces. Tube and box: scales radius / extent by widening_factor.
+    SearchRegion widened(const Embedding& _em) const;
+
+    /// How find_shortest_path proceeds if no path exists within the region.
+    double widening_factor = 2.0;
+    int max_widenings = 3;
+    bool fall_back_to_unrestricted = true;
+
+private:
+    enum class Type
+    {
+        Faces,
+        Tube,
+        Box,
+    };
+    Type type = Type::Box;
+
+    /// Tube: guide segments by uniform grid cell, so contains only tests the segments near the queried position.
+    struct SegmentGrid;
+    void build_segment_grid();
+
+    std::shared_ptr<const std::unordered_set<int>> t_faces; // Shared among copies
+    std::shared_ptr<const std::vector<tg::pos3>> guide;
+    std::shared_ptr<const SegmentGrid> segment_grid; // Depends on radius
+    double radius = 0.0;
+    tg::aabb3 bounds;
+};
+
+}
@@ -1,7 +1,7 @@
 #include "Snake.hh"
 
 #include <LayoutEmbedding/Util/Assert.hh>
-#include <LayoutEmbedding/ExactPredicates.h>
+#include <LayoutEmbedding/Predicates.hh>
 
 namespace LayoutEmbedding
 {
@@ -9,14 +9,7 @@ namespace LayoutEmbedding
 namespace
 {
 
-const double* ptr(
-        const tg::dpos2& _p)
-{
-    return &_p.x;
-}
-
 /**
- * CALL exactinit() once before calling this function!
  * Does straight line segment (a, b) intersect (c, d)?
  * Inclusive: touching an endpoint counts as intersection.
  */
@@ -24,21 +17,16 @@ bool intersects_exact_inclusive_2d(
         const tg::dpos2& a, const tg::dpos2& b,
         const tg::dpos2& c, const tg::dpos2& d)
 {
-    const auto sign1 = orient2d(ptr(a), ptr(b), ptr(c));
-    const auto sign2 = orient2d(ptr(a), ptr(d), ptr(b));
-    const auto sign3 = orient2d(ptr(a), ptr(d), ptr(c));
-    const auto sign4 = orient2d(ptr(b), ptr(c), ptr(d));
+    // All four orientation tests as one batch
+    const auto signs = orient2d_signs<4>({ a, a, a, b }, { b, d, d, c }, { c, b, c, d });
 
     int n_negative = 0;
     int n_positive = 0;
-    if (sign1 <= 0) ++n_negative;
-    if (sign1 >= 0) ++n_positive;
-    if (sign2 <= 0) ++n_negative;
-    if (sign2 >= 0) ++n_positive;
-    if (sign3 <= 0) ++n_negative;
-    if (sign3 >= 0) ++n_positive;
-    if (sign4 <= 0) ++n_negative;
-    if (sign4 >= 0) ++n_positive;
+    for (const int sign : signs)
+    {
+        if (sign <= 0) ++n_negative;
+        if (sign >= 0) ++n_positive;
+    }
 
     if (n_negative == 4 || n_positive == 4)
         return true;
@@ -148,7 +136,6 @@ Snake snake_from_parametrization(
         const pm::vertex_handle& _v_from,
         const pm::vertex_handle& _v_to)
 {
-    exactinit();
     LE_ASSERT(_v_from != _v_to);
 
     SnakeVertex sv_from { _v_from.any_outgoing_halfedge(), 0.0 };
@@ -0,0 +1,266 @@
+#include "TentativePath.hh"
+
+#include <LayoutEmbedding/Connectivity.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <queue>
+
+namespace LayoutEmbedding {
+
+TentativePath::TentativePath(const Embedding& _em, const pm::edge_handle& _l_e, const VirtualPath& _path) :
+    em(_em),
+    l_e(_l_e)
+{
+    LE_ASSERT(_l_e.mesh == &em.layout_mesh());
+    LE_ASSERT(!em.is_embedded(_l_e));
+    LE_ASSERT_GEQ(_path.size(), 2);
+    LE_ASSERT(is_real_vertex(_path.front()));
+    LE_ASSERT(is_real_vertex(_path.back()));
+
+    const pm::Mesh& t_m = em.target_mesh();
+
+    // Path segments, see VirtualPathConflictSentinel::insert_segment
+    for (int i = 0; i < _path.size() - 1; ++i) {
+        const auto& vv0 = _path[i];
+        const auto& vv1 = _path[i+1];
+        if (is_real_vertex(vv0)) {
+            if (is_real_vertex(vv1)) {
+                // (V,V) case
+                const auto t_h = pm::halfedge_from_to(real_vertex(vv0, t_m), real_vertex(vv1, t_m));
+                LE_ASSERT(t_h.is_valid());
+                blocked_edges.insert(t_h.edge().idx.value);
+            }
+            else {
+                // (V,E) case
+                const auto t_v = real_vertex(vv0, t_m);
+                const auto t_e = real_edge(vv1, t_m);
+                const auto t_f = triangle_with_edge_and_opposite_vertex(t_e, t_v);
+                LE_ASSERT(t_f.is_valid());
+                add_cut(t_f, vertex_position(t_f, t_v), edge_position(t_f, t_e));
+            }
+        }
+        else {
+            if (is_real_vertex(vv1)) {
+                // (E,V) case
+                const auto t_e = real_edge(vv0, t_m);
+                const auto t_v = real_vertex(vv1, t_m);
+                const auto t_f = triangle_with_edge_and_opposite_vertex(t_e, t_v);
+                LE_ASSERT(t_f.is_valid());
+                add_cut(t_f, edge_position(t_f, t_e), vertex_position(t_f, t_v));
+            }
+            else {
+                // (E,E) case
+                const auto t_e0 = real_edge(vv0, t_m);
+                const auto t_e1 = real_edge(vv1, t_m);
+                const auto t_f = common_face(t_e0, t_e1);
+                LE_ASSERT(t_f.is_valid());
+                add_cut(t_f, edge_position(t_f, t_e0), edge_position(t_f, t_e1));
+            }
+        }
+    }
+
+    if (!valid) {
+        return;
+    }
+
+    // The region left of a path starts at the piece left of its first segment.
+    auto find_start = [&](const VirtualVertex& _vv_start, const VirtualVertex& _vv_next, const Piece _side, pm::face_handle& _t_f, Piece& _piece) {
+        const auto t_v = real_vertex(_vv_start, t_m);
+        if (is_real_vertex(_vv_next)) {
+            const auto t_h = pm::halfedge_from_to(t_v, real_vertex(_vv_next, t_m));
+            _t_f = t_h.face();
+            if (_t_f.is_valid()) {
+                _piece = piece_of_segment(_t_f, halfedge_position(_t_f, t_h));
+            }
+        }
+        else {
+            _t_f = triangle_with_edge_and_opposite_vertex(real_edge(_vv_next, t_m), t_v);
+            _piece = _side;
+        }
+        if (_t_f.is_invalid()) {
+            valid = false;
+        }
+    };
+    const int n = _path.size();
+    find_start(_path[0], _path[1], Left, t_f_start_A, piece_start_A);
+    find_start(_path[n - 1], _path[n - 2], Right, t_f_start_B, piece_start_B); // Reversed path: Its left is our right.
+}
+
+bool TentativePath::is_embedded(const pm::halfedge_handle& _l_he) const
+{
+    return _l_he.edge() == l_e || em.is_embedded(_l_he);
+}
+
+bool TentativePath::flood_fill_layout(const pm::halfedge_handle& _l_he, const std::function<bool(const pm::face_handle&)>& _visit) const
+{
+    LE_ASSERT(_l_he.mesh == &em.layout_mesh());
+
+    std::unordered_set<int> visited;
+    std::queue<pm::halfedge_handle> queue;
+    queue.push(_l_he);
+    while (!queue.empty()) {
+        const auto l_h = queue.front();
+        const auto l_f = l_h.face();
+        queue.pop();
+
+        if (!visited.insert(l_f.idx.value).second) {
+            continue;
+        }
+
+        if (!_visit(l_f)) {
+            return false;
+        }
+
+        for (const auto l_h_f : l_f.halfedges()) {
+            const auto l_h_opp = l_h_f.opposite();
+            if (!is_embedded(l_h_opp) && !visited.count(l_h_opp.face().idx.value)) {
+                queue.push(l_h_opp);
+            }
+        }
+    }
+    return true;
+}
+
+bool TentativePath::flood_fill_target(const pm::halfedge_handle& _l_he, const std::function<bool(const pm::vertex_handle&)>& _visit) const
+{
+    LE_ASSERT(valid);
+    LE_ASSERT(_l_he.edge() == l_e);
+
+    // Visited (face, piece) pairs
+    std::unordered_set<int> visited;
+    auto key = [](const pm::face_handle& _t_f, const Piece _piece) {
+        return 3 * _t_f.idx.value + (int)_piece;
+    };
+
+    std::queue<std::pair<pm::face_handle, Piece>> queue;
+    if (_l_he == l_e.halfedgeA()) {
+        queue.push({t_f_start_A, piece_start_A});
+    }
+    else {
+        queue.push({t_f_start_B, piece_start_B});
+    }
+
+    while (!queue.empty()) {
+        const auto [t_f, piece] = queue.front();
+        queue.pop();
+
+        if (!visited.insert(key(t_f, piece)).second) {
+            continue;
+        }
+
+        // Collect corners
+        auto t_h = t_f.any_halfedge();
+        for (int k = 0; k < 3; ++k) {
+            if (corner_in_piece(t_f, piece, 2 * k)) {
+                if (!_visit(t_h.vertex_from())) {
+                    return false;
+                }
+            }
+            t_h = t_h.next();
+        }
+
+        // Enqueue neighbors across the two halves of each unblocked edge
+        t_h = t_f.any_halfedge();
+        for (int k = 0; k < 3; ++k) {
+            const auto t_e = t_h.edge();
+            const auto t_h_opp = t_h.opposite();
+            const auto t_f_opp = t_h_opp.face();
+            if (!em.is_blocked(t_e) && !blocked_edges.count(t_e.idx.value) && t_f_opp.is_valid()) {
+                const int k_opp = halfedge_position(t_f_opp, t_h_opp) / 2;
+                for (int half = 0; half < 2; ++half) {
+                    if (piece_of_segment(t_f, 2 * k + half) != piece) {
+                        continue;
+                    }
+                    // The first half of t_h is the second half of t_h_opp
+                    const Piece piece_opp = piece_of_segment(t_f_opp, 2 * k_opp + (1 - half));
+                    if (!visited.count(key(t_f_opp, piece_opp))) {
+                        queue.push({t_f_opp, piece_opp});
+                    }
+                }
+            }
+            t_h = t_h.next();
+        }
+    }
+    return true;
+}
+
+int TentativePath::halfedge_position(const pm::face_handle& _f, const pm::halfedge_handle& _h)
+{
+    auto h = _f.any_halfedge();
+    for (int k = 0; k < 3; ++k) {
+        if (h == _h) {
+            return 2 * k;
+        }
+        h = h.next();
+    }
+    LE_ERROR_THROW("Halfedge not found in face.");
+}
+
+int TentativePath::vertex_position(const pm::face_handle& _f, const pm::vertex_handle& _v)
+{
+    auto h = _f.any_halfedge();
+    for (int k = 0; k < 3; ++k) {
+        if (h.vertex_from() == _v) {
+            return 2 * k;
+        }
+        h = h.next();
+    }
+    LE_ERROR_THROW("Vertex not found in face.");
+}
+
+int TentativePath::edge_position(const pm::face_handle& _f, const pm::edge_handle& _e)
+{
+    auto h = _f.any_halfedge();
+    for (int k = 0; k < 3; ++k) {
+        if (h.edge() == _e) {
+            return 2 * k + 1;
+        }
+        h = h.next();
+    }
+    LE_ERROR_THROW("Edge not found in face.");
+}
+
+void TentativePath::add_cut(const pm::face_handle& _f, const int _from, const int _to)
+{
+    LE_ASSERT_NEQ(_from, _to);
+    if (!cuts.emplace(_f.idx.value, Cut{_from, _to}).second) {
+        // The path crosses this face twice. Not supported.
+        valid = false;
+    }
+}
+
+TentativePath::Piece TentativePath::piece_of_segment(const pm::face_handle& _f, const int _j) const
+{
+    const auto it = cuts.find(_f.idx.value);
+    if (it == cuts.end()) {
+        return Whole;
+    }
+
+    // In a ccw face, the boundary from the end of a cut (ccw) to its start lies on the left.
+    const int a = it->second.from;
+    const int b = it->second.to;
+    if ((_j - b + 6) % 6 < (a - b + 6) % 6) {
+        return Left;
+    }
+    else {
+        return Right;
+    }
+}
+
+bool TentativePath::corner_in_piece(const pm::face_handle& _f, const Piece _piece, const int _p) const
+{
+    const auto it = cuts.find(_f.idx.value);
+    if (it == cuts.end()) {
+        return true;
+    }
+
+    // Corners on the cut belong to both pieces
+    const int a = it->second.from;
+    const int b = it->second.to;
+    if (_p == a || _p == b) {
+        return true;
+    }
+    return piece_of_segment(_f, _p) == _piece;
+}
+
+}
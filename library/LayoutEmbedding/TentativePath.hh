@@ -0,0 +1,81 @@
+#pragma once
+
+#include <LayoutEmbedding/Embedding.hh>
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace LayoutEmbedding {
+
+/// A path that is tentatively embedded into an Embedding without modifying its target mesh.
+/// Each target face crossed by the path is treated as two pieces, left and right of the path.
+/// Requires a triangular target mesh.
+/// This allows answering region queries (as if the path was embedded) at a cost proportional to the visited region,
+/// instead of copying the Embedding and splitting its target mesh.
+class TentativePath
+{
+public:
+    /// _path is oriented like _l_e.halfedgeA().
+    TentativePath(const Embedding& _em, const pm::edge_handle& _l_e, const VirtualPath& _path);
+
+    /// False if the path crosses a target face more than once.
+    /// In that case, the queries below are unavailable and the path has to be embedded for real.
+    bool is_valid() const { return valid; }
+
+    /// Like Embedding::is_embedded, but also true for both halfedges of the tentative layout edge.
+    bool is_embedded(const pm::halfedge_handle& _l_he) const;
+
+    /// Visits the layout faces reachable from the face of _l_he without crossing embedded layout edges.
+    /// Stops early (and returns false) once _visit returns false.
+    bool flood_fill_layout(const pm::halfedge_handle& _l_he, const std::function<bool(const pm::face_handle&)>& _visit) const;
+
+    /// Visits the vertices of the target region that lies on the left of the (tentatively embedded) layout halfedge _l_he,
+    /// i.e. the region reachable from the face of Embedding::get_embedded_target_halfedge(_l_he) without crossing
+    /// embedded paths. _l_he has to be a halfedge of the tentative layout edge.
+    /// Vertices might be visited multiple times.
+    /// Stops early (and returns false) once _visit returns false.
+    bool flood_fill_target(const pm::halfedge_handle& _l_he, const std::function<bool(const pm::vertex_handle&)>& _visit) const;
+
+private:
+    enum Piece
+    {
+        Whole = 0,
+        Left = 1,
+        Right = 2,
+    };
+
+    struct Cut
+    {
+        // Positions on the face boundary: 2k is the vertex_from of the k-th halfedge, 2k+1 is its midpoint.
+        int from;
+        int to;
+    };
+
+    static int halfedge_position(const pm::face_handle& _f, const pm::halfedge_handle& _h);
+    static int vertex_position(const pm::face_handle& _f, const pm::vertex_handle& _v);
+    static int edge_position(const pm::face_handle& _f, const pm::edge_handle& _e);
+
+    void add_cut(const pm::face_handle& _f, const int _from, const int _to);
+
+    /// Piece of _f containing the boundary segment between positions _j and _j+1.
+    Piece piece_of_segment(const pm::face_handle& _f, const int _j) const;
+
+    /// Whether the corner at position _p of _f belongs to _piece.
+    bool corner_in_piece(const pm::face_handle& _f, const Piece _piece, const int _p) const;
+
+    const Embedding& em;
+    const pm::edge_handle l_e;
+    bool valid = true;
+
+    std::unordered_map<int, Cut> cuts; // Face index -> cut
+    std::unordered_set<int> blocked_edges; // Target edges along the path
+
+    // Start of the target region left of l_e.halfedgeA() / l_e.halfedgeB()
+    pm::face_handle t_f_start_A;
+    pm::face_handle t_f_start_B;
+    Piece piece_start_A = Whole;
+    Piece piece_start_B = Whole;
+};
+
+}
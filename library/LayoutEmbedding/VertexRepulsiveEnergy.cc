@@ -4,9 +4,9 @@
 
 namespace LayoutEmbedding {
 
-Eigen::MatrixXd compute_vertex_repulsive_energy(const Embedding& _em)
+Eigen::MatrixXd compute_vertex_repulsive_energy(const Embedding& _em, const VertexRepulsiveEnergySettings& _settings)
 {
-    const int l_num_v = _em.layout_mesh().vertices().size();
+    const int l_num_v = _em.layout_mesh().all_vertices().size(); // Columns are indexed by (possibly non-compact) layout vertex indices
     const int t_num_v = _em.target_mesh().vertices().size();
 
     // Set up boundary conditions
@@ -21,10 +21,104 @@ Eigen::MatrixXd compute_vertex_repulsive_energy(const Embedding& _em)
     }
 
     // Compute l_num_v many harmonic fields
+    // The columns share one factorization and are solved in parallel.
+    HarmonicSettings harmonic_settings;
+    harmonic_settings.weights = LaplaceWeights::MeanValue;
+    harmonic_settings.rhs_chunk_size = _settings.rhs_chunk_size;
     Eigen::MatrixXd W;
-    LE_ASSERT(harmonic(_em.target_pos(), constrained, constraint_values, W, LaplaceWeights::MeanValue));
+    LE_ASSERT(harmonic(_em.target_pos(), constrained, constraint_values, W, harmonic_settings));
+
+    if (_settings.sparsify_threshold > 0.0)
+        W = (W.array().abs() < _settings.sparsify_threshold).select(0.0, W.array()).matrix();
 
     return W;
 }
 
+SharedVertexRepulsiveEnergies::SharedVertexRepulsiveEnergies(int _max_size) :
+    max_size(_max_size)
+{
+}
+
+void SharedVertexRepulsiveEnergies::expect(const std::vector<int>& _landmarks)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++pending[_landmarks];
+}
+
+void SharedVertexRepulsiveEnergies::apply(Embedding& _em)
+{
+    std::vector<int> landmarks;
+    for (const auto l_v : _em.layout_mesh().vertices()) {
+        landmarks.push_back(_em.matching_target_vertex(l_v).idx.value);
+    }
+
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& e = entries[landmarks];
+        if (!e) {
+            e = std::make_shared<Entry>();
+        }
+        e->last_used = ++clock;
+        entry = e;
+        if (max_size > 0 && (int)entries.size() > max_size) {
+            drop_least_recently_used();
+        }
+    }
+
+    // Jobs with other landmarks are not blocked while this one is computed.
+    // A dropped entry stays alive until all jobs currently using it are done.
+    std::call_once(entry->computed, [&] {
+        entry->vre = compute_vertex_repulsive_energy(_em, _em.vertex_repulsive_energy_settings());
+        std::lock_guard<std::mutex> lock(mutex);
+        entry->bytes = sizeof(double) * entry->vre.size();
+        ++n_computed;
+    });
+    _em.set_vertex_repulsive_energy(entry->vre);
+
+    // Drop the energy after the last announced job
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it_pending = pending.find(landmarks);
+    if (it_pending != pending.end() && --it_pending->second == 0) {
+        pending.erase(it_pending);
+        const auto it = entries.find(landmarks);
+        if (it != entries.end() && it->second == entry) {
+            entries.erase(it);
+        }
+    }
+}
+
+void SharedVertexRepulsiveEnergies::drop_least_recently_used()
+{
+    auto lru = entries.begin();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->second->last_used < lru->second->last_used) {
+            lru = it;
+        }
+    }
+    entries.erase(lru);
+}
+
+int SharedVertexRepulsiveEnergies::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+int SharedVertexRepulsiveEnergies::num_computed() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return n_computed;
+}
+
+double SharedVertexRepulsiveEnergies::memory() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    double bytes = 0.0;
+    for (const auto& [landmarks, entry] : entries) {
+        bytes += entry->bytes;
+    }
+    return bytes;
+}
+
 }
@@ -4,8 +4,63 @@
 
 #include <Eigen/Dense>
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace LayoutEmbedding {
 
-Eigen::MatrixXd compute_vertex_repulsive_energy(const Embedding& _em);
+/// Harmonic fields (one column per layout vertex) that are 1 at the respective landmark and 0 at all others [Praun2001].
+/// Entries below _settings.sparsify_threshold are set to zero.
+Eigen::MatrixXd compute_vertex_repulsive_energy(const Embedding& _em, const VertexRepulsiveEnergySettings& _settings = VertexRepulsiveEnergySettings());
+
+/// Vertex repulsive energies on one target mesh, computed at most once per distinct set of landmarks.
+/// Can be used concurrently by several jobs.
+/// Each energy is a dense (#target vertices x #layout vertices) matrix, so the number of kept energies is bounded:
+/// by max_size (least recently used energies are dropped first) and, for announced landmarks (see expect),
+/// by dropping an energy once all announced jobs have applied it.
+/// A dropped energy is computed again if it is needed later.
+class SharedVertexRepulsiveEnergies
+{
+public:
+    /// Keeps at most _max_size energies. Set to <= 0 for no limit.
+    explicit SharedVertexRepulsiveEnergies(int _max_size = 0);
+
+    /// Announces a job with the given landmarks (target vertex id per layout vertex, in layout vertex order).
+    void expect(const std::vector<int>& _landmarks);
+
+    /// Computes the energy for the landmarks of _em if necessary and applies it to _em.
+    /// _em must not have any embedded paths yet.
+    void apply(Embedding& _em);
+
+    /// Number of energies currently kept.
+    int size() const;
+
+    /// Number of energies computed so far, including dropped ones.
+    int num_computed() const;
+
+    /// Bytes used by the energies currently kept.
+    double memory() const;
+
+private:
+    struct Entry
+    {
+        std::once_flag computed;
+        Eigen::MatrixXd vre;
+        double bytes = 0.0; // Set once vre is computed
+        int last_used = 0;
+    };
+
+    void drop_least_recently_used();
+
+    int max_size = 0;
+    int clock = 0;
+    int n_computed = 0;
+
+    mutable std::mutex mutex;
+    std::map<std::vector<int>, std::shared_ptr<Entry>> entries;
+    std::map<std::vector<int>, int> pending; // Announced jobs that have not applied their energy yet
+};
 
 }
@@ -0,0 +1,84 @@
+#include "VertexRepulsiveEnergyRow.hh"
+
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace LayoutEmbedding {
+
+VertexRepulsiveEnergyRow::VertexRepulsiveEnergyRow(const Eigen::VectorXd& _values, const VertexRepulsiveEnergySettings& _settings) :
+    size(_values.size()),
+    single_precision(_settings.single_precision),
+    sparse(_settings.sparsify_threshold > 0.0)
+{
+    Eigen::VectorXd stored = _values;
+    if (sparse) {
+        for (int i = 0; i < size; ++i) {
+            if (std::abs(_values[i]) >= _settings.sparsify_threshold) {
+                indices.push_back(i);
+            }
+        }
+        stored.resize(indices.size());
+        for (int k = 0; k < (int)indices.size(); ++k) {
+            stored[k] = _values[indices[k]];
+        }
+    }
+
+    if (single_precision) {
+        values_f = stored.cast<float>();
+    }
+    else {
+        values_d = std::move(stored);
+    }
+}
+
+double VertexRepulsiveEnergyRow::stored_value(const int _k) const
+{
+    return single_precision ? (double)values_f[_k] : values_d[_k];
+}
+
+double VertexRepulsiveEnergyRow::operator[](const int _l_v_idx) const
+{
+    LE_ASSERT(_l_v_idx >= 0 && _l_v_idx < size);
+
+    if (!sparse) {
+        return stored_value(_l_v_idx);
+    }
+
+    const auto it = std::lower_bound(indices.begin(), indices.end(), _l_v_idx);
+    if (it == indices.end() || *it != _l_v_idx) {
+        return 0.0;
+    }
+    return stored_value(it - indices.begin());
+}
+
+Eigen::VectorXd VertexRepulsiveEnergyRow::to_dense() const
+{
+    Eigen::VectorXd result = Eigen::VectorXd::Zero(size);
+    if (sparse) {
+        for (int k = 0; k < (int)indices.size(); ++k) {
+            result[indices[k]] = stored_value(k);
+        }
+    }
+    else {
+        for (int i = 0; i < size; ++i) {
+            result[i] = stored_value(i);
+        }
+    }
+    return result;
+}
+
+VertexRepulsiveEnergyRow VertexRepulsiveEnergyRow::midpoint(const VertexRepulsiveEnergyRow& _a, const VertexRepulsiveEnergyRow& _b)
+{
+    LE_ASSERT_EQ(_a.size, _b.size);
+
+    // Sparse rows keep every entry that is stored in either row
+    VertexRepulsiveEnergySettings settings;
+    settings.single_precision = _a.single_precision;
+    settings.sparsify_threshold = _a.sparse ? std::numeric_limits<double>::min() : 0.0;
+    return VertexRepulsiveEnergyRow(0.5 * _a.to_dense() + 0.5 * _b.to_dense(), settings);
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+#include <vector>
+
+namespace LayoutEmbedding {
+
+struct VertexRepulsiveEnergySettings
+{
+    /// Right-hand side columns (one per layout vertex) are solved in parallel chunks of this size.
+    /// Set to <= 0 to solve all columns at once.
+    int rhs_chunk_size = 4;
+
+    /// Store the energies in single precision.
+    bool single_precision = false;
+
+    /// If > 0, energies below this value are treated as zero and not stored.
+    double sparsify_threshold = 0.0;
+};
+
+/// Vertex repulsive energies of one target vertex with respect to all layout vertices,
+/// stored in the format given by VertexRepulsiveEnergySettings.
+class VertexRepulsiveEnergyRow
+{
+public:
+    VertexRepulsiveEnergyRow() = default;
+    VertexRepulsiveEnergyRow(const Eigen::VectorXd& _values, const VertexRepulsiveEnergySettings& _settings);
+
+    /// Energy with respect to the layout vertex with index _l_v_idx.
+    double operator[](const int _l_v_idx) const;
+
+    Eigen::VectorXd to_dense() const;
+
+    /// Average of two rows, in the format of _a (used for vertices inserted on target edges).
+    static VertexRepulsiveEnergyRow midpoint(const VertexRepulsiveEnergyRow& _a, const VertexRepulsiveEnergyRow& _b);
+
+private:
+    double stored_value(const int _k) const;
+
+    int size = 0;
+    bool single_precision = false;
+    bool sparse = false;
+
+    // Either all values (dense) or the values at indices (sparse). Only one of them is used.
+    Eigen::VectorXd values_d;
+    Eigen::VectorXf values_f;
+    std::vector<int> indices; // Sorted
+};
+
+}
@@ -4,27 +4,50 @@
 
 #include <polymesh/pm.hh>
 
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 namespace LayoutEmbedding {
 
+/// Per-element storage for the virtual vertices of a mesh.
+/// Unlike pm attributes, it does not register with the mesh, so it can be created concurrently
+/// (e.g. by several shortest path searches on the same Embedding).
+/// In sparse mode, only accessed elements are stored, so the cost is proportional to the number of accessed elements
+/// instead of the mesh size. Unaccessed elements are default-constructed in both modes.
 template <typename T>
 struct VirtualVertexAttribute
 {
-    pm::vertex_attribute<T> v_a;
-    pm::edge_attribute<T> e_a;
+    std::vector<T> v_a;
+    std::vector<T> e_a;
+
+    bool sparse = false;
+    std::unordered_map<std::int64_t, T> sparse_a; // Key: 2 * vertex index or 2 * edge index + 1
 
-    VirtualVertexAttribute(const pm::Mesh& _m) :
-        v_a(_m),
-        e_a(_m)
+    explicit VirtualVertexAttribute(const pm::Mesh& _m, const bool _sparse = false) :
+        sparse(_sparse)
     {
+        if (!sparse) {
+            v_a.resize(_m.all_vertices().size());
+            e_a.resize(_m.all_edges().size());
+        }
     }
 
     T& operator[](const VirtualVertex& _el)
     {
+        if (sparse) {
+            if (is_real_vertex(_el)) {
+                return sparse_a[2 * (std::int64_t)real_vertex(_el).value];
+            }
+            else {
+                return sparse_a[2 * (std::int64_t)real_edge(_el).value + 1];
+            }
+        }
         if (is_real_vertex(_el)) {
-            return v_a[real_vertex(_el)];
+            return v_a[real_vertex(_el).value];
         }
         else {
-            return e_a[real_edge(_el)];
+            return e_a[real_edge(_el).value];
         }
     }
 };